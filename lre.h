@@ -69,6 +69,22 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 /* Offset from the actual value of fraction exponent */
 #define LRE_EXPONENT_BIAS 16383
 
+/* Dense tags are lowercase versions of regular tags */
+#define LRE_TAG_DENSE_FLAG 0x20
+
+/* The first character of dense alphabet, the alphabet is '-'..'l' */
+#define LRE_DENSE_FIRST '-'
+
+/* Maximal payload of dense and binary numbers transcoded for handlers (bytes) */
+#define LRE_TRANSCODE_NUMBER_MAX 256
+
+/* Terminators of binary values */
+#define LRE_BIN_TERM_POSITIVE 0x00
+#define LRE_BIN_TERM_NEGATIVE 0xff
+
+/* Escape of zero byte in binary strings: 0x00 -> 0x00 0xff */
+#define LRE_BIN_ESCAPE 0xff
+
 
 #if !defined(lre_decl)
 	#if defined(__cplusplus) || defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 199901L)
@@ -98,6 +114,47 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #endif
 
 
+/* Default growth of buffer capacity in percent (100 is exact growth) */
+#if !defined(LRE_BUFFER_GROWTH)
+	#define LRE_BUFFER_GROWTH 200
+#endif
+
+/* Default number of consecutive small resets before buffer shrinks (0 is always) */
+#if !defined(LRE_BUFFER_SHRINK_AFTER)
+	#define LRE_BUFFER_SHRINK_AFTER 8
+#endif
+
+/* Default size of arena chunk */
+#if !defined(LRE_ARENA_CHUNK)
+	#define LRE_ARENA_CHUNK 65536
+#endif
+
+/* Alignment of arena blocks. Must be a power of two and >= sizeof(size_t) */
+#if !defined(LRE_ARENA_ALIGN)
+	#define LRE_ARENA_ALIGN 16
+#endif
+
+/* Number of capacity buckets of buffer pool, bucket b holds capacity >= LRE_POOL_MIN<<b */
+#if !defined(LRE_POOL_BUCKETS)
+	#define LRE_POOL_BUCKETS 16
+#endif
+
+/* Capacity of the smallest pool bucket */
+#if !defined(LRE_POOL_MIN)
+	#define LRE_POOL_MIN 64
+#endif
+
+/* Maximal number of buffers per bucket in thread cache of buffer pool */
+#if !defined(LRE_POOL_CACHE)
+	#define LRE_POOL_CACHE 8
+#endif
+
+/* Number of pools that one thread caches at once, the least recently used cache is flushed */
+#if !defined(LRE_POOL_THREAD_CACHES)
+	#define LRE_POOL_THREAD_CACHES 4
+#endif
+
+
 /* Branch prediction macro for if-statements.
  * Almost all branches in this library are well predictable. */
 #if defined(__GNUC__) || defined(__clang__)
@@ -119,6 +176,114 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #endif
 
 
+/* SIMD kernels are compiled for every instruction set that the compiler
+ * can target and selected at runtime (see lre_set_isa).
+ * Define LRE_NO_SIMD to force portable scalar code. */
+#if !defined(LRE_NO_SIMD)
+	#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+		#define LRE_SIMD_SSE2 1
+	#endif
+
+	/* AVX2 kernels do not require -mavx2 */
+	#if defined(__AVX2__) || (defined(LRE_SIMD_SSE2) && (defined(__GNUC__) || defined(__clang__) || defined(_MSC_VER)))
+		#define LRE_SIMD_AVX2 1
+	#endif
+
+	#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+		#define LRE_SIMD_NEON 1
+	#endif
+
+	#if defined(__BMI2__)
+		#define LRE_SIMD_BMI2 1
+	#endif
+#endif
+
+#if defined(LRE_SIMD_AVX2) || defined(LRE_SIMD_BMI2)
+	#include <immintrin.h>
+#elif defined(LRE_SIMD_SSE2)
+	#include <emmintrin.h>
+#endif
+
+#if defined(LRE_SIMD_AVX2) && defined(_MSC_VER)
+	#include <intrin.h>
+#endif
+
+#if defined(LRE_SIMD_NEON)
+	#include <arm_neon.h>
+#endif
+
+#if defined(LRE_SIMD_SSE2) || defined(LRE_SIMD_NEON)
+	#define LRE_SIMD 1
+#endif
+
+#if defined(LRE_SIMD_AVX2) && !defined(__AVX2__) && (defined(__GNUC__) || defined(__clang__))
+	#define LRE_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+	#define LRE_TARGET_AVX2
+#endif
+
+
+#if defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__)
+	#if (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__) && !defined(LRE_BIG_ENDIAN)
+		#define LRE_BIG_ENDIAN 1
+	#endif
+#endif
+
+
+/* 128-bit integers (lre_pack_int128, handler_int128).
+ * Define LRE_NO_INT128 to exclude them. */
+#if defined(__SIZEOF_INT128__) && !defined(LRE_NO_INT128)
+	#define LRE_INT128 1
+
+	__extension__ typedef __int128          lre_int128_t;
+	__extension__ typedef unsigned __int128 lre_uint128_t;
+#endif
+
+
+/* Thread-local storage and atomics for buffer pool.
+ * Define LRE_NO_THREADS to exclude buffer pool. */
+#if !defined(LRE_NO_THREADS)
+	#if !defined(LRE_THREAD_LOCAL)
+		#if defined(__cplusplus) && __cplusplus >= 201103L
+			#define LRE_THREAD_LOCAL thread_local
+		#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && !defined(__STDC_NO_THREADS__)
+			#define LRE_THREAD_LOCAL _Thread_local
+		#elif defined(__GNUC__) || defined(__clang__)
+			#define LRE_THREAD_LOCAL __thread
+		#elif defined(_MSC_VER)
+			#define LRE_THREAD_LOCAL __declspec(thread)
+		#endif
+	#endif
+
+	#if defined(__GNUC__) || defined(__clang__)
+		#define LRE_ATOMIC_GNU 1
+	#elif defined(_MSC_VER)
+		#include <intrin.h>
+		#define LRE_ATOMIC_MSVC 1
+	#endif
+
+	#if defined(LRE_THREAD_LOCAL) && (defined(LRE_ATOMIC_GNU) || defined(LRE_ATOMIC_MSVC))
+		#define LRE_POOL 1
+	#endif
+
+	/* Workers of lre_tokenize_batch_mt() */
+	#if (defined(__unix__) || defined(__APPLE__)) && !defined(_WIN32)
+		#include <pthread.h>
+		#define LRE_PTHREADS 1
+	#endif
+#endif
+
+
+/* Prefetch for reading, used by batch functions */
+#if !defined(lre_prefetch)
+	#if defined(__GNUC__) || defined(__clang__)
+		#define lre_prefetch(p) __builtin_prefetch((p), 0, 3)
+	#else
+		#define lre_prefetch(p) ((void) (p))
+	#endif
+#endif
+
+
 #if defined(LRE_DEBUG)
 	#define lre_debug(...) (printf("%s:%i: ", __FUNCTION__, __LINE__), printf(__VA_ARGS__))
 	#define lre_fail(error, to) ((lre_debug("%s\n", lre_strerror(error)), to) ? *(to)=error, error : error)
@@ -169,9 +334,17 @@ typedef enum {
 
 /* String encodings */
 typedef enum {
-	LRE_ENC_NONE = 0,  /* The same as LRE_ENC_RAW */
-	LRE_ENC_RAW  = 'H',
-	LRE_ENC_UTF8 = 'L'
+	LRE_ENC_NONE       = 0,  /* The same as LRE_ENC_RAW */
+	LRE_ENC_RAW        = 'H',
+	LRE_ENC_UTF8       = 'L',
+
+	/* Encodings of dense strings. Must be less than LRE_DENSE_FIRST */
+	LRE_ENC_DENSE_RAW  = '*',
+	LRE_ENC_DENSE_UTF8 = ',',
+
+	/* Encodings of binary strings */
+	LRE_ENC_BIN_RAW    = 'h',
+	LRE_ENC_BIN_UTF8   = 'l'
 } lre_enc_t;
 
 
@@ -186,7 +359,9 @@ typedef enum {
 	LRE_ERROR_TAG,
 	LRE_ERROR_SIGN,
 	LRE_ERROR_ENC,
-	LRE_ERROR_HANDLER
+	LRE_ERROR_HANDLER,
+	LRE_ERROR_CHAR,
+	LRE_ERROR_TYPE
 } lre_error_t;
 
 
@@ -204,6 +379,8 @@ const char *lre_strerror(lre_error_t error) {
 		case LRE_ERROR_SIGN:             return "Unknown sign";
 		case LRE_ERROR_ENC:              return "Unknown string encoding";
 		case LRE_ERROR_HANDLER:          return "Final value cannot be handled";
+		case LRE_ERROR_CHAR:             return "Invalid character";
+		case LRE_ERROR_TYPE:             return "Unknown value type";
 		default:                         return "Unknown error";
 	}
 }
@@ -232,6 +409,26 @@ uint64_t lrex_negate_negative(int64_t value) {
 }
 
 
+/**
+ * @brief Convert magnitude and sign of integer to 64-bit signed value
+ * @param integral Absolute value
+ * @param negative_mask 0xff for negative numbers, 0 otherwise
+ * @param out Pointer to value (output)
+ * @param error Pointer to lre_error_t or 0
+ * @return LRE_OK if success, LRE_FAIL (LRE_ERROR_RANGE) if value is out of 64-bit range
+ */
+lre_decl
+int lrex_int_from_magnitude(uint64_t integral, uint8_t negative_mask, int64_t *out, lre_error_t *error) {
+	/* Negative range is one more: -9223372036854775808 */
+	if (lre_unlikely(integral > UINT64_C(9223372036854775807) + (negative_mask & 1))) {
+		return lre_fail(LRE_ERROR_RANGE, error);
+	}
+
+	*out = negative_mask ? lrex_negate_positive(integral) : (int64_t) integral;
+	return LRE_OK;
+}
+
+
 /**
  * @brief Returns tag for positive number according to number of bytes
  * @param nbytes Number of bytes (lrex_count_nbytes). Strictly from 1 to 8.
@@ -272,6 +469,45 @@ int lrex_nbytes_by_tag_negative(lre_tag_t numeric_tag) {
 }
 
 
+/* */
+lre_decl
+int lrex_tag_is_dense(lre_tag_t tag) {
+	return ((int) tag & LRE_TAG_DENSE_FLAG) != 0;
+}
+
+
+/**
+ * @brief Returns dense tag of regular tag
+ */
+lre_decl
+lre_tag_t lrex_tag_dense(lre_tag_t tag) {
+	return (lre_tag_t) ((int) tag | LRE_TAG_DENSE_FLAG);
+}
+
+
+/**
+ * @brief Returns regular tag of dense tag
+ */
+lre_decl
+lre_tag_t lrex_tag_regular(lre_tag_t tag) {
+	return (lre_tag_t) ((int) tag & ~LRE_TAG_DENSE_FLAG);
+}
+
+
+/* */
+lre_decl
+int lrex_enc_is_dense(lre_enc_t enc) {
+	return enc == LRE_ENC_DENSE_RAW || enc == LRE_ENC_DENSE_UTF8;
+}
+
+
+/* */
+lre_decl
+int lrex_enc_is_bin(lre_enc_t enc) {
+	return enc == LRE_ENC_BIN_RAW || enc == LRE_ENC_BIN_UTF8;
+}
+
+
 /* */
 lre_decl
 int lrex_tag_is_string(lre_tag_t tag) {
@@ -372,6 +608,105 @@ int lrex_log2i(uint64_t value) {
 }
 
 
+/**
+ * @brief Counting of trailing zero bits.
+ * @param value Value. Must NOT be 0
+ * @return Index of the lowest set bit
+ */
+lre_decl
+int lrex_ctz64(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_ctzll(value);
+#else
+	/* Isolated lowest bit has the same log2 as its index */
+	return lrex_log2i(value & (~value + 1));
+#endif
+}
+
+
+lre_decl
+uint64_t lrex_bswap64(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_bswap64(value);
+#elif defined(_MSC_VER)
+	return _byteswap_uint64(value);
+#else
+	value = ((value & UINT64_C(0x00ff00ff00ff00ff)) << 8)  | ((value >> 8)  & UINT64_C(0x00ff00ff00ff00ff));
+	value = ((value & UINT64_C(0x0000ffff0000ffff)) << 16) | ((value >> 16) & UINT64_C(0x0000ffff0000ffff));
+	return (value << 32) | (value >> 32);
+#endif
+}
+
+
+/**
+ * @brief Unaligned load of big-endian 64-bit word
+ */
+lre_decl
+uint64_t lrex_load_be64(const uint8_t *src) {
+	uint64_t value;
+	memcpy(&value, src, sizeof(value));
+
+#if defined(LRE_BIG_ENDIAN)
+	return value;
+#else
+	return lrex_bswap64(value);
+#endif
+}
+
+
+/**
+ * @brief Unaligned store of big-endian 64-bit word
+ */
+lre_decl
+void lrex_store_be64(uint8_t *dst, uint64_t value) {
+#if !defined(LRE_BIG_ENDIAN)
+	value = lrex_bswap64(value);
+#endif
+
+	memcpy(dst, &value, sizeof(value));
+}
+
+
+/**
+ * @brief SWAR encoding of 32-bit value to 8 nibble characters.
+ * @return Big-endian word, the most significant nibble is the first character
+ */
+lre_decl
+uint64_t lrex_nibbles_spread(uint32_t value) {
+#if defined(LRE_SIMD_BMI2)
+	uint64_t x = _pdep_u64(value, UINT64_C(0x0f0f0f0f0f0f0f0f));
+#else
+	uint64_t x = value;
+
+	x = (x | (x << 16)) & UINT64_C(0x0000ffff0000ffff);
+	x = (x | (x << 8))  & UINT64_C(0x00ff00ff00ff00ff);
+	x = (x | (x << 4))  & UINT64_C(0x0f0f0f0f0f0f0f0f);
+#endif
+
+	return x + UINT64_C(0x6161616161616161);
+}
+
+
+/**
+ * @brief SWAR decoding of 8 nibble characters to 32-bit value.
+ * @param value Big-endian word, the first character is the most significant byte
+ */
+lre_decl
+uint32_t lrex_nibbles_gather(uint64_t value) {
+	uint64_t x = value - UINT64_C(0x6161616161616161);
+
+#if defined(LRE_SIMD_BMI2)
+	return (uint32_t) _pext_u64(x, UINT64_C(0x0f0f0f0f0f0f0f0f));
+#else
+	x = (x | (x >> 4))  & UINT64_C(0x00ff00ff00ff00ff);
+	x = (x | (x >> 8))  & UINT64_C(0x0000ffff0000ffff);
+	x = (x | (x >> 16)) & UINT64_C(0x00000000ffffffff);
+
+	return (uint32_t) x;
+#endif
+}
+
+
 lre_decl
 void lrex_write_char(uint8_t **dst, uint8_t value) {
 	*(*dst)++ = value;
@@ -392,8 +727,23 @@ void lrex_write_uint16(uint8_t **dst, uint16_t value) {
 }
 
 
+/**
+ * @brief Write nbytes least significant bytes of value (big-endian, nbytes*2 characters).
+ * @param nbytes Number of bytes, from 0 to 8
+ */
 lre_decl
 void lrex_write_uint64n(uint8_t **dst, uint64_t value, size_t nbytes) {
+	if (lre_likely(nbytes >= 4)) {
+		/* Leading 4 bytes and trailing 4 bytes, overlapped part is written twice */
+		uint64_t head = lrex_nibbles_spread((uint32_t) (value >> ((nbytes - 4) * 8)));
+		uint64_t tail = lrex_nibbles_spread((uint32_t) value);
+
+		lrex_store_be64(*dst, head);
+		lrex_store_be64(*dst + nbytes * 2 - 8, tail);
+		*dst += nbytes * 2;
+		return;
+	}
+
 	while (nbytes--) {
 		int byte = (value >> (nbytes * 8)) & 0xff;
 		lrex_write_uint8(dst, byte);
@@ -401,134 +751,5188 @@ void lrex_write_uint64n(uint8_t **dst, uint64_t value, size_t nbytes) {
 }
 
 
-lre_decl
-void lrex_write_str(uint8_t **dst, const uint8_t *src, size_t len, uint8_t mask) {
-	while (len--) {
-		int byte = *src++ ^ mask;
-		lrex_write_uint8(dst, byte);
-	}
-}
+/* Instruction sets of kernels */
+typedef enum {
+	LRE_ISA_AUTO = 0, /* The best supported or LRE_ISA environment variable */
+	LRE_ISA_SCALAR,
+	LRE_ISA_SSE2,
+	LRE_ISA_AVX2,
+	LRE_ISA_NEON
+} lre_isa_t;
 
 
-lre_decl
-uint8_t lrex_read_char(const uint8_t **src) {
-	return *(*src)++;
-}
+/* Table of kernels for one instruction set */
+typedef struct {
+	lre_isa_t isa;
+	size_t  (*write_str)(uint8_t *dst, const uint8_t *src, size_t len, uint8_t mask);
+	size_t  (*read_str) (uint8_t *dst, const uint8_t *src, size_t nbytes, uint8_t mask, int *check);
+	size_t  (*memsep)   (const uint8_t *src, size_t size);
+	size_t  (*sepmask)  (const uint8_t *src, size_t size, uint64_t *bits);
+	size_t  (*range)    (const uint8_t *src, size_t size, uint8_t first, uint8_t last, int *check);
+} lre_kernels_t;
 
 
 lre_decl
-uint8_t lrex_read_uint8(const uint8_t **src, uint8_t mask) {
-	int a = lrex_read_char(src) - 'a';
-	int b = lrex_read_char(src) - 'a';
-	return ((a << 4) | b) ^ mask;
-}
+const lre_kernels_t *lrex_kernels(void);
+
 
+/* Scalar kernels do nothing, the remainder is always processed by scalar code */
 
 lre_decl
-uint16_t lrex_read_uint16(const uint8_t **src, uint8_t mask) {
-	int a = lrex_read_uint8(src, mask);
-	int b = lrex_read_uint8(src, mask);
-	return (a << 8) | b;
+size_t lrex_write_str_scalar(uint8_t *dst, const uint8_t *src, size_t len, uint8_t mask) {
+	return 0;
 }
 
 
 lre_decl
-uint64_t lrex_read_uint64n(const uint8_t **src, size_t nbytes, uint8_t mask) {
-	uint64_t value = 0;
-	
-	while (nbytes--) {
-		value = (value << 8) | lrex_read_uint8(src, mask);
-	}
-	
-	return value;
+size_t lrex_read_str_scalar(uint8_t *dst, const uint8_t *src, size_t nbytes, uint8_t mask, int *check) {
+	return 0;
 }
 
 
 lre_decl
-void lrex_read_str(const uint8_t **src, uint8_t *dst, size_t nbytes, uint8_t mask) {
-	while (nbytes--) {
-		*dst++ = lrex_read_uint8(src, mask);
-	}
+size_t lrex_memsep_scalar(const uint8_t *src, size_t size) {
+	return 0;
 }
 
 
 lre_decl
-const uint8_t *lrex_memsep(const uint8_t *src, size_t size) {
-	for (; size; size--, src++) {
-		if (*src == LRE_SEP_POSITIVE || *src == LRE_SEP_NEGATIVE) {
-			return src;
-		}
-	}
-	
+size_t lrex_sepmask_scalar(const uint8_t *src, size_t size, uint64_t *bits) {
 	return 0;
 }
 
-/*
- * */
-typedef struct {
-	const uint8_t *src; /* Pointer to first character */
-	const uint8_t *end; /* Pointer to next to last character */
-} lre_slice_t;
-
 
-/**
- * @brief Returns length of slice
- * @param slice Pointer to lre_slice_t object
- */
 lre_decl
-ptrdiff_t lre_slice_len(const lre_slice_t *slice) {
-	return slice->end - slice->src;
+size_t lrex_range_scalar(const uint8_t *src, size_t size, uint8_t first, uint8_t last, int *check) {
+	return 0;
 }
 
 
-/**
- * @brief Returns last byte and shifts end of slice
- * @param slice Pointer to lre_slice_t object
+/*
+ * String kernels write len*2 characters and return the number of
+ * consumed source bytes (always a multiple of the vector width).
+ * The rest of the string is processed by the scalar code.
  */
+
+#if defined(LRE_SIMD_SSE2)
 lre_decl
-uint8_t lre_slice_pop(lre_slice_t *slice) {
-	return *(--slice->end);
+size_t lrex_write_str_sse2(uint8_t *dst, const uint8_t *src, size_t len, uint8_t mask) {
+	const __m128i vmask  = _mm_set1_epi8((char) mask);
+	const __m128i vlow   = _mm_set1_epi8(0x0f);
+	const __m128i valpha = _mm_set1_epi8('a');
+	size_t i = 0;
+
+	for (; i + 16 <= len; i += 16) {
+		__m128i x  = _mm_xor_si128(_mm_loadu_si128((const __m128i *) (src + i)), vmask);
+		__m128i hi = _mm_add_epi8(_mm_and_si128(_mm_srli_epi16(x, 4), vlow), valpha);
+		__m128i lo = _mm_add_epi8(_mm_and_si128(x, vlow), valpha);
+
+		_mm_storeu_si128((__m128i *) (dst + i * 2),      _mm_unpacklo_epi8(hi, lo));
+		_mm_storeu_si128((__m128i *) (dst + i * 2 + 16), _mm_unpackhi_epi8(hi, lo));
+	}
+
+	return i;
 }
+#endif
 
 
-/* LRE MEMORY BUFFER.
- * Normally, it is long-lived objects in one thread. */
-typedef struct {
-	uint8_t *data;     /* Payload */
-	size_t   size;     /* Payload length */
-	size_t   capacity; /* Total *data allocated space  */
-	size_t   reserved; /* Minimal *data allocated space */
-} lre_buffer_t;
+#if defined(LRE_SIMD_AVX2)
+lre_decl LRE_TARGET_AVX2
+size_t lrex_write_str_avx2(uint8_t *dst, const uint8_t *src, size_t len, uint8_t mask) {
+	const __m256i vmask  = _mm256_set1_epi8((char) mask);
+	const __m256i vlow   = _mm256_set1_epi8(0x0f);
+	const __m256i valpha = _mm256_set1_epi8('a');
+	size_t i = 0;
 
+	for (; i + 32 <= len; i += 32) {
+		__m256i x  = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *) (src + i)), vmask);
+		__m256i hi = _mm256_add_epi8(_mm256_and_si256(_mm256_srli_epi16(x, 4), vlow), valpha);
+		__m256i lo = _mm256_add_epi8(_mm256_and_si256(x, vlow), valpha);
 
-/**
- * @brief Reallocate memory.
- * @param buf Pointer to lre_buffer_t
- * @param capacity New capacity of buffer
- * @param error Pointer to lre_error_t or 0
- * @return LRE_OK if success, LRE_FAIL otherwise
- */
-lre_decl
-int lre_buffer_reallocate(lre_buffer_t *buf, size_t capacity, lre_error_t *error) {
-	lre_debug("%i reserved=%i size=%i\n", (int) capacity, (int) buf->reserved, (int) buf->size);
+		/* Unpacking works within 128-bit lanes: [0..7 16..23] and [8..15 24..31] */
+		__m256i a  = _mm256_unpacklo_epi8(hi, lo);
+		__m256i b  = _mm256_unpackhi_epi8(hi, lo);
 
-	if (lre_unlikely(capacity < buf->reserved)) {
-		capacity = buf->reserved;
+		_mm256_storeu_si256((__m256i *) (dst + i * 2),      _mm256_permute2x128_si256(a, b, 0x20));
+		_mm256_storeu_si256((__m256i *) (dst + i * 2 + 32), _mm256_permute2x128_si256(a, b, 0x31));
 	}
 
-	if (lre_unlikely(capacity < buf->size)) {
-		return lre_fail(LRE_ERROR_ALLOCATION_SMALL, error);
-	}
+	return i;
+}
+#endif
 
-	{
-		uint8_t *data = lre_std_realloc(buf->data, capacity);
+
+#if defined(LRE_SIMD_NEON)
+lre_decl
+size_t lrex_write_str_neon(uint8_t *dst, const uint8_t *src, size_t len, uint8_t mask) {
+	const uint8x16_t vmask  = vdupq_n_u8(mask);
+	const uint8x16_t vlow   = vdupq_n_u8(0x0f);
+	const uint8x16_t valpha = vdupq_n_u8('a');
+	size_t i = 0;
+
+	for (; i + 16 <= len; i += 16) {
+		uint8x16_t   x = veorq_u8(vld1q_u8(src + i), vmask);
+		uint8x16x2_t out;
+
+		out.val[0] = vaddq_u8(vshrq_n_u8(x, 4), valpha);
+		out.val[1] = vaddq_u8(vandq_u8(x, vlow), valpha);
+
+		/* Interleaving store: hi0 lo0 hi1 lo1 ... */
+		vst2q_u8(dst + i * 2, out);
+	}
+
+	return i;
+}
+#endif
+
+
+lre_decl
+void lrex_write_str(uint8_t **dst, const uint8_t *src, size_t len, uint8_t mask) {
+	size_t done = 0;
+
+#if defined(LRE_SIMD)
+	if (len >= 16) {
+		done = lrex_kernels()->write_str(*dst, src, len, mask);
+	}
+#endif
+
+	*dst += done * 2;
+	src  += done;
+	len  -= done;
+
+	while (len--) {
+		int byte = *src++ ^ mask;
+		lrex_write_uint8(dst, byte);
+	}
+}
+
+
+/**
+ * @brief Branchless version of lrex_write_uint64n.
+ *
+ * Always writes 16 characters, but shifts *dst by nbytes*2 only.
+ * Destination must have at least 16 characters of space.
+ *
+ * @param nbytes Number of bytes, strictly from 1 to 8
+ */
+lre_decl
+void lrex_write_uint64n_wide(uint8_t **dst, uint64_t value, size_t nbytes) {
+	value <<= (8 - nbytes) * 8;
+
+#if defined(LRE_SIMD_SSE2) && !defined(LRE_SIMD_BMI2) && !defined(LRE_BIG_ENDIAN)
+	{
+		/* The same nibble interleaving as lrex_write_str_sse2() */
+		const __m128i vlow = _mm_set1_epi8(0x0f);
+		uint64_t be = lrex_bswap64(value);
+		__m128i  x  = _mm_loadl_epi64((const __m128i *) &be);
+		__m128i  hi = _mm_and_si128(_mm_srli_epi16(x, 4), vlow);
+		__m128i  lo = _mm_and_si128(x, vlow);
+
+		_mm_storeu_si128((__m128i *) *dst, _mm_add_epi8(_mm_unpacklo_epi8(hi, lo), _mm_set1_epi8('a')));
+	}
+#else
+	lrex_store_be64(*dst,     lrex_nibbles_spread((uint32_t) (value >> 32)));
+	lrex_store_be64(*dst + 8, lrex_nibbles_spread((uint32_t) value));
+#endif
+
+	*dst += nbytes * 2;
+}
+
+
+lre_decl
+uint8_t lrex_read_char(const uint8_t **src) {
+	return *(*src)++;
+}
+
+
+lre_decl
+uint8_t lrex_read_uint8(const uint8_t **src, uint8_t mask) {
+	int a = lrex_read_char(src) - 'a';
+	int b = lrex_read_char(src) - 'a';
+	return ((a << 4) | b) ^ mask;
+}
+
+
+lre_decl
+uint16_t lrex_read_uint16(const uint8_t **src, uint8_t mask) {
+	int a = lrex_read_uint8(src, mask);
+	int b = lrex_read_uint8(src, mask);
+	return (a << 8) | b;
+}
+
+
+/**
+ * @brief Read nbytes*2 characters as big-endian integer.
+ * @param nbytes Number of bytes, from 0 to 8
+ * @param mask 0xff for negative numbers, 0 otherwise
+ */
+lre_decl
+uint64_t lrex_read_uint64n(const uint8_t **src, size_t nbytes, uint8_t mask) {
+	uint64_t value = 0;
+
+	if (lre_likely(nbytes >= 4)) {
+		/* Leading 4 bytes and trailing 4 bytes, overlapped part is ORed with itself */
+		uint64_t used = ((UINT64_C(1) << (nbytes * 4)) << (nbytes * 4)) - 1;
+		uint64_t head;
+		uint64_t tail;
+
+#if defined(LRE_SIMD_SSE2) && !defined(LRE_SIMD_BMI2) && !defined(LRE_BIG_ENDIAN)
+		{
+			/* The same nibble packing as lrex_read_str_sse2() */
+			const __m128i vlow = _mm_set1_epi16(0x00ff);
+			__m128i h = _mm_loadl_epi64((const __m128i *) *src);
+			__m128i t = _mm_loadl_epi64((const __m128i *) (*src + nbytes * 2 - 8));
+			__m128i x = _mm_sub_epi8(_mm_unpacklo_epi64(h, t), _mm_set1_epi8('a'));
+			uint64_t be;
+
+			x = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(x, vlow), 4), _mm_srli_epi16(x, 8));
+			_mm_storel_epi64((__m128i *) &be, _mm_packus_epi16(x, x));
+
+			be   = lrex_bswap64(be);
+			head = be >> 32;
+			tail = be & UINT64_C(0xffffffff);
+		}
+#else
+		head = lrex_nibbles_gather(lrex_load_be64(*src));
+		tail = lrex_nibbles_gather(lrex_load_be64(*src + nbytes * 2 - 8));
+#endif
+
+		*src += nbytes * 2;
+		value = (head << ((nbytes - 4) * 8)) | tail;
+
+		return value ^ (used & (mask * UINT64_C(0x0101010101010101)));
+	}
+	
+	while (nbytes--) {
+		value = (value << 8) | lrex_read_uint8(src, mask);
+	}
+	
+	return value;
+}
+
+
+/*
+ * Decoding kernels read nbytes*2 characters, write nbytes and return
+ * the number of decoded bytes (always a multiple of the vector width).
+ * Every character outside of 'a'..'p' sets bits in *check.
+ */
+
+#if defined(LRE_SIMD_SSE2)
+lre_decl
+size_t lrex_read_str_sse2(uint8_t *dst, const uint8_t *src, size_t nbytes, uint8_t mask, int *check) {
+	const __m128i vmask  = _mm_set1_epi8((char) mask);
+	const __m128i vlow   = _mm_set1_epi16(0x00ff);
+	const __m128i vhigh  = _mm_set1_epi8((char) 0xf0);
+	const __m128i valpha = _mm_set1_epi8('a');
+	__m128i acc = _mm_setzero_si128();
+	size_t i = 0;
+
+	for (; i + 16 <= nbytes; i += 16) {
+		__m128i a = _mm_sub_epi8(_mm_loadu_si128((const __m128i *) (src + i * 2)),      valpha);
+		__m128i b = _mm_sub_epi8(_mm_loadu_si128((const __m128i *) (src + i * 2 + 16)), valpha);
+
+		acc = _mm_or_si128(acc, _mm_or_si128(a, b));
+
+		/* Every 16-bit word holds high nibble in low byte and low nibble in high byte */
+		a = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(a, vlow), 4), _mm_srli_epi16(a, 8));
+		b = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(b, vlow), 4), _mm_srli_epi16(b, 8));
+
+		_mm_storeu_si128((__m128i *) (dst + i), _mm_xor_si128(_mm_packus_epi16(a, b), vmask));
+	}
+
+	*check |= _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(acc, vhigh), _mm_setzero_si128())) ^ 0xffff;
+	return i;
+}
+#endif
+
+
+#if defined(LRE_SIMD_AVX2)
+lre_decl LRE_TARGET_AVX2
+size_t lrex_read_str_avx2(uint8_t *dst, const uint8_t *src, size_t nbytes, uint8_t mask, int *check) {
+	const __m256i vmask  = _mm256_set1_epi8((char) mask);
+	const __m256i vlow   = _mm256_set1_epi16(0x00ff);
+	const __m256i vhigh  = _mm256_set1_epi8((char) 0xf0);
+	const __m256i valpha = _mm256_set1_epi8('a');
+	__m256i acc = _mm256_setzero_si256();
+	size_t i = 0;
+
+	for (; i + 32 <= nbytes; i += 32) {
+		__m256i a = _mm256_sub_epi8(_mm256_loadu_si256((const __m256i *) (src + i * 2)),      valpha);
+		__m256i b = _mm256_sub_epi8(_mm256_loadu_si256((const __m256i *) (src + i * 2 + 32)), valpha);
+
+		acc = _mm256_or_si256(acc, _mm256_or_si256(a, b));
+
+		a = _mm256_or_si256(_mm256_slli_epi16(_mm256_and_si256(a, vlow), 4), _mm256_srli_epi16(a, 8));
+		b = _mm256_or_si256(_mm256_slli_epi16(_mm256_and_si256(b, vlow), 4), _mm256_srli_epi16(b, 8));
+
+		/* Packing works within 128-bit lanes: [a0 b0 a1 b1] -> [a0 a1 b0 b1] */
+		a = _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xd8);
+
+		_mm256_storeu_si256((__m256i *) (dst + i), _mm256_xor_si256(a, vmask));
+	}
+
+	*check |= !_mm256_testz_si256(acc, vhigh);
+	return i;
+}
+#endif
+
+
+#if defined(LRE_SIMD_NEON)
+lre_decl
+size_t lrex_read_str_neon(uint8_t *dst, const uint8_t *src, size_t nbytes, uint8_t mask, int *check) {
+	const uint8x16_t vmask  = vdupq_n_u8(mask);
+	const uint8x16_t vhigh  = vdupq_n_u8(0xf0);
+	const uint8x16_t valpha = vdupq_n_u8('a');
+	uint8x16_t acc = vdupq_n_u8(0);
+	uint8x8_t  half;
+	size_t i = 0;
+
+	for (; i + 16 <= nbytes; i += 16) {
+		/* Deinterleaving load: val[0] is high nibbles, val[1] is low nibbles */
+		uint8x16x2_t in = vld2q_u8(src + i * 2);
+		uint8x16_t   hi = vsubq_u8(in.val[0], valpha);
+		uint8x16_t   lo = vsubq_u8(in.val[1], valpha);
+
+		acc = vorrq_u8(acc, vorrq_u8(hi, lo));
+		vst1q_u8(dst + i, veorq_u8(vorrq_u8(vshlq_n_u8(hi, 4), lo), vmask));
+	}
+
+	acc  = vandq_u8(acc, vhigh);
+	half = vorr_u8(vget_low_u8(acc), vget_high_u8(acc));
+	*check |= vget_lane_u64(vreinterpret_u64_u8(half), 0) != 0;
+	return i;
+}
+#endif
+
+
+/**
+ * @brief Decode string and check that every character belongs to nibble alphabet ('a'..'p').
+ * @param src Pointer to pointer to encoded string. Shifted by nbytes*2
+ * @param dst Destination with at least nbytes of space
+ * @param nbytes Number of decoded bytes
+ * @param mask 0xff for negative numbers, 0 otherwise
+ * @return LRE_OK if all characters are valid, LRE_FAIL otherwise (dst is filled anyway)
+ */
+lre_decl
+int lrex_read_str_checked(const uint8_t **src, uint8_t *dst, size_t nbytes, uint8_t mask) {
+	size_t done = 0;
+	int    check = 0;
+
+#if defined(LRE_SIMD)
+	if (nbytes >= 16) {
+		done = lrex_kernels()->read_str(dst, *src, nbytes, mask, &check);
+	}
+#endif
+
+	*src   += done * 2;
+	dst    += done;
+	nbytes -= done;
+
+	while (nbytes--) {
+		int a = lrex_read_char(src) - 'a';
+		int b = lrex_read_char(src) - 'a';
+
+		check |= (a | b) & ~0xf;
+		*dst++ = ((a << 4) | b) ^ mask;
+	}
+
+	return check ? LRE_FAIL : LRE_OK;
+}
+
+
+lre_decl
+void lrex_read_str(const uint8_t **src, uint8_t *dst, size_t nbytes, uint8_t mask) {
+	lrex_read_str_checked(src, dst, nbytes, mask);
+}
+
+
+/*
+ * DENSE ENCODING.
+ * Every character holds 6 bits, big-endian. The alphabet is a contiguous
+ * range of ASCII characters between the separators, so lexicographic order
+ * is preserved. Unused bits of the last character are filled by the mask:
+ * negative numbers are padded by ones and remain ordered.
+ */
+
+/**
+ * @brief Returns number of characters of dense encoded nbytes
+ */
+lre_decl
+size_t lrex_dense_nchars(size_t nbytes) {
+	return (nbytes * 4 + 2) / 3;
+}
+
+
+/**
+ * @brief Returns number of bytes of nchars dense characters
+ */
+lre_decl
+size_t lrex_dense_nbytes(size_t nchars) {
+	return nchars * 3 / 4;
+}
+
+
+/**
+ * @brief SWAR encoding of 48-bit value to 8 dense characters.
+ * @return Big-endian word, the most significant sextet is the first character
+ */
+lre_decl
+uint64_t lrex_sextets_spread(uint64_t value) {
+#if defined(LRE_SIMD_BMI2)
+	uint64_t x = _pdep_u64(value, UINT64_C(0x3f3f3f3f3f3f3f3f));
+#else
+	uint64_t x = value;
+
+	x = ((x & UINT64_C(0x0000ffffff000000)) << 8) | (x & UINT64_C(0x0000000000ffffff));
+	x = ((x & UINT64_C(0x00fff00000fff000)) << 4) | (x & UINT64_C(0x00000fff00000fff));
+	x = ((x & UINT64_C(0x0fc00fc00fc00fc0)) << 2) | (x & UINT64_C(0x003f003f003f003f));
+#endif
+
+	return x + UINT64_C(0x2d2d2d2d2d2d2d2d);
+}
+
+
+/**
+ * @brief SWAR decoding of 8 dense characters to 48-bit value.
+ * @param value Big-endian word, the first character is the most significant byte
+ * @param check Bits are set for characters outside of the dense alphabet
+ */
+lre_decl
+uint64_t lrex_sextets_gather(uint64_t value, uint64_t *check) {
+	uint64_t x = value - UINT64_C(0x2d2d2d2d2d2d2d2d);
+
+	*check |= x & UINT64_C(0xc0c0c0c0c0c0c0c0);
+
+#if defined(LRE_SIMD_BMI2)
+	return _pext_u64(x, UINT64_C(0x3f3f3f3f3f3f3f3f));
+#else
+	x = ((x & UINT64_C(0x3f003f003f003f00)) >> 2) | (x & UINT64_C(0x003f003f003f003f));
+	x = ((x & UINT64_C(0x0fff00000fff0000)) >> 4) | (x & UINT64_C(0x00000fff00000fff));
+	x = ((x & UINT64_C(0x00ffffff00000000)) >> 8) | (x & UINT64_C(0x0000000000ffffff));
+
+	return x;
+#endif
+}
+
+
+/**
+ * @brief Write dense encoded string (lrex_dense_nchars(len) characters)
+ * @param mask 0xff for negative numbers, 0 otherwise. Also fills unused bits
+ */
+lre_decl
+void lrex_write_dense(uint8_t **dst, const uint8_t *src, size_t len, uint8_t mask) {
+	const uint64_t wmask = mask * UINT64_C(0x0101010101010101);
+
+	/* 6 bytes to 8 characters, 8 bytes are loaded */
+	for (; len >= 8; src += 6, len -= 6) {
+		uint64_t value = ((lrex_load_be64(src) ^ wmask) >> 16);
+
+		lrex_store_be64(*dst, lrex_sextets_spread(value));
+		*dst += 8;
+	}
+
+	for (; len >= 3; src += 3, len -= 3) {
+		uint32_t value = ((src[0] << 16) | (src[1] << 8) | src[2]) ^ (wmask & 0xffffff);
+
+		lrex_write_char(dst, LRE_DENSE_FIRST + ((value >> 18) & 0x3f));
+		lrex_write_char(dst, LRE_DENSE_FIRST + ((value >> 12) & 0x3f));
+		lrex_write_char(dst, LRE_DENSE_FIRST + ((value >> 6)  & 0x3f));
+		lrex_write_char(dst, LRE_DENSE_FIRST + ( value        & 0x3f));
+	}
+
+	if (len) {
+		/* Missing bytes are equal to mask */
+		uint32_t value = (uint32_t) (src[0] ^ mask) << 16 | mask;
+
+		value |= (uint32_t) ((len == 2) ? (src[1] ^ mask) : mask) << 8;
+
+		lrex_write_char(dst, LRE_DENSE_FIRST + ((value >> 18) & 0x3f));
+		lrex_write_char(dst, LRE_DENSE_FIRST + ((value >> 12) & 0x3f));
+
+		if (len == 2) {
+			lrex_write_char(dst, LRE_DENSE_FIRST + ((value >> 6) & 0x3f));
+		}
+	}
+}
+
+
+/**
+ * @brief Decode dense string and check that every character belongs to dense alphabet.
+ * @param src Pointer to pointer to encoded string. Shifted by nchars
+ * @param dst Destination with at least lrex_dense_nbytes(nchars) of space
+ * @param nchars Number of characters. nchars%4 must NOT be 1
+ * @param mask 0xff for negative numbers, 0 otherwise
+ * @return LRE_OK if all characters are valid, LRE_FAIL otherwise (dst is filled anyway)
+ */
+lre_decl
+int lrex_read_dense(const uint8_t **src, uint8_t *dst, size_t nchars, uint8_t mask) {
+	const uint64_t wmask = mask * UINT64_C(0x0101010101010101);
+	uint64_t check = 0;
+	uint8_t  tmp[8];
+
+	for (; nchars >= 8; nchars -= 8, dst += 6) {
+		uint64_t value = lrex_sextets_gather(lrex_load_be64(*src), &check) ^ wmask;
+
+		lrex_store_be64(tmp, value << 16);
+		memcpy(dst, tmp, 6);
+		*src += 8;
+	}
+
+	while (nchars >= 2) {
+		size_t   n = (nchars >= 4) ? 4 : nchars;
+		uint32_t value = 0;
+		size_t   i;
+
+		for (i = 0; i < 4; i++) {
+			int c = (i < n) ? lrex_read_char(src) - LRE_DENSE_FIRST : 0;
+
+			check |= c & ~0x3f;
+			value  = (value << 6) | (c & 0x3f);
+		}
+
+		value ^= wmask & 0xffffff;
+		nchars -= n;
+
+		/* 4 characters hold 3 bytes, 3 characters hold 2 bytes, 2 characters hold 1 byte */
+		for (i = 0; i < n - 1; i++) {
+			*dst++ = value >> (16 - i * 8);
+		}
+	}
+
+	return check ? LRE_FAIL : LRE_OK;
+}
+
+
+/*
+ * BINARY ENCODING.
+ * Strings are raw bytes where 0x00 is escaped as 0x00 0xff and terminated
+ * by 0x00 followed by encoding. Numbers are big-endian bytes, complemented
+ * for negative values.
+ */
+
+/**
+ * @brief Write escaped binary string
+ * @param dst Destination with at least len*2 of space
+ */
+lre_decl
+void lrex_write_bin_str(uint8_t **dst, const uint8_t *src, size_t len) {
+	const uint8_t *end = src + len;
+	const uint8_t *zero;
+
+	while ((zero = memchr(src, 0x00, end - src))) {
+		memcpy(*dst, src, zero - src);
+		*dst += zero - src;
+		lrex_write_char(dst, 0x00);
+		lrex_write_char(dst, LRE_BIN_ESCAPE);
+		src = zero + 1;
+	}
+
+	memcpy(*dst, src, end - src);
+	*dst += end - src;
+}
+
+
+/**
+ * @brief Returns number of bytes of unescaped binary string
+ * @param src Escaped string without terminator
+ * @param len Length of escaped string
+ */
+lre_decl
+size_t lrex_bin_str_nbytes(const uint8_t *src, size_t len) {
+	const uint8_t *end = src + len;
+	size_t nbytes = len;
+
+	while ((src = memchr(src, 0x00, end - src))) {
+		nbytes--;
+		src += 2;
+
+		if (src >= end) {
+			break;
+		}
+	}
+
+	return nbytes;
+}
+
+
+/**
+ * @brief Unescape binary string.
+ * @param src Pointer to pointer to escaped string without terminator. Shifted by len
+ * @param dst Destination with at least lrex_bin_str_nbytes() of space
+ * @param len Length of escaped string
+ * @return LRE_OK if success, LRE_FAIL if 0x00 is not followed by escape
+ */
+lre_decl
+int lrex_read_bin_str(const uint8_t **src, uint8_t *dst, size_t len) {
+	const uint8_t *end = *src + len;
+	const uint8_t *zero;
+
+	while ((zero = memchr(*src, 0x00, end - *src))) {
+		memcpy(dst, *src, zero - *src);
+		dst += zero - *src;
+		*dst++ = 0x00;
+
+		if (lre_unlikely(zero + 1 >= end || zero[1] != LRE_BIN_ESCAPE)) {
+			*src = end;
+			return LRE_FAIL;
+		}
+
+		*src = zero + 2;
+	}
+
+	memcpy(dst, *src, end - *src);
+	*src = end;
+
+	return LRE_OK;
+}
+
+
+/*
+ * Separator kernels return offset of the first separator or number of
+ * scanned bytes (multiple of the vector width) if it was not found.
+ * Mask kernels set a bit for every separator and return number of
+ * scanned bytes (multiple of 64).
+ */
+
+#if defined(LRE_SIMD_SSE2)
+lre_decl
+int lrex_sepmask16_sse2(const uint8_t *src) {
+	const __m128i x = _mm_loadu_si128((const __m128i *) src);
+	const __m128i p = _mm_cmpeq_epi8(x, _mm_set1_epi8(LRE_SEP_POSITIVE));
+	const __m128i n = _mm_cmpeq_epi8(x, _mm_set1_epi8(LRE_SEP_NEGATIVE));
+
+	return _mm_movemask_epi8(_mm_or_si128(p, n));
+}
+
+
+lre_decl
+size_t lrex_memsep_sse2(const uint8_t *src, size_t size) {
+	size_t i = 0;
+
+	for (; i + 16 <= size; i += 16) {
+		int bits = lrex_sepmask16_sse2(src + i);
+
+		if (bits) {
+			return i + lrex_ctz64(bits);
+		}
+	}
+
+	return i;
+}
+
+
+lre_decl
+size_t lrex_sepmask_sse2(const uint8_t *src, size_t size, uint64_t *bits) {
+	size_t i = 0;
+
+	for (; i + 64 <= size; i += 64) {
+		uint64_t a = (uint16_t) lrex_sepmask16_sse2(src + i);
+		uint64_t b = (uint16_t) lrex_sepmask16_sse2(src + i + 16);
+		uint64_t c = (uint16_t) lrex_sepmask16_sse2(src + i + 32);
+		uint64_t d = (uint16_t) lrex_sepmask16_sse2(src + i + 48);
+
+		*bits++ = a | (b << 16) | (c << 32) | (d << 48);
+	}
+
+	return i;
+}
+#endif
+
+
+#if defined(LRE_SIMD_AVX2)
+lre_decl LRE_TARGET_AVX2
+uint32_t lrex_sepmask32_avx2(const uint8_t *src) {
+	const __m256i x = _mm256_loadu_si256((const __m256i *) src);
+	const __m256i p = _mm256_cmpeq_epi8(x, _mm256_set1_epi8(LRE_SEP_POSITIVE));
+	const __m256i n = _mm256_cmpeq_epi8(x, _mm256_set1_epi8(LRE_SEP_NEGATIVE));
+
+	return (uint32_t) _mm256_movemask_epi8(_mm256_or_si256(p, n));
+}
+
+
+lre_decl LRE_TARGET_AVX2
+size_t lrex_memsep_avx2(const uint8_t *src, size_t size) {
+	size_t i = 0;
+
+	for (; i + 32 <= size; i += 32) {
+		uint32_t bits = lrex_sepmask32_avx2(src + i);
+
+		if (bits) {
+			return i + lrex_ctz64(bits);
+		}
+	}
+
+	return i;
+}
+
+
+lre_decl LRE_TARGET_AVX2
+size_t lrex_sepmask_avx2(const uint8_t *src, size_t size, uint64_t *bits) {
+	size_t i = 0;
+
+	for (; i + 64 <= size; i += 64) {
+		uint64_t a = lrex_sepmask32_avx2(src + i);
+		uint64_t b = lrex_sepmask32_avx2(src + i + 32);
+
+		*bits++ = a | (b << 32);
+	}
+
+	return i;
+}
+#endif
+
+
+#if defined(LRE_SIMD_NEON)
+/* Returns 4 bits per each byte of 16 (narrowing shift instead of movemask) */
+lre_decl
+uint64_t lrex_sepmask16_neon(const uint8_t *src) {
+	const uint8x16_t x = vld1q_u8(src);
+	const uint8x16_t p = vceqq_u8(x, vdupq_n_u8(LRE_SEP_POSITIVE));
+	const uint8x16_t n = vceqq_u8(x, vdupq_n_u8(LRE_SEP_NEGATIVE));
+	const uint8x8_t  m = vshrn_n_u16(vreinterpretq_u16_u8(vorrq_u8(p, n)), 4);
+
+	return vget_lane_u64(vreinterpret_u64_u8(m), 0);
+}
+
+
+lre_decl
+size_t lrex_memsep_neon(const uint8_t *src, size_t size) {
+	size_t i = 0;
+
+	for (; i + 16 <= size; i += 16) {
+		uint64_t bits = lrex_sepmask16_neon(src + i);
+
+		if (bits) {
+			return i + (lrex_ctz64(bits) >> 2);
+		}
+	}
+
+	return i;
+}
+
+
+lre_decl
+size_t lrex_sepmask_neon(const uint8_t *src, size_t size, uint64_t *bits) {
+	size_t i = 0;
+
+	for (; i + 64 <= size; i += 64) {
+		uint64_t word = 0;
+		int k;
+
+		for (k = 0; k < 4; k++) {
+			/* Compress one bit of each nibble into 16 bits */
+			uint64_t x = lrex_sepmask16_neon(src + i + k * 16) & UINT64_C(0x1111111111111111);
+
+			x = (x | (x >> 3))  & UINT64_C(0x0303030303030303);
+			x = (x | (x >> 6))  & UINT64_C(0x000f000f000f000f);
+			x = (x | (x >> 12)) & UINT64_C(0x000000ff000000ff);
+			x = (x | (x >> 24)) & UINT64_C(0x000000000000ffff);
+
+			word |= x << (k * 16);
+		}
+
+		*bits++ = word;
+	}
+
+	return i;
+}
+#endif
+
+
+/**
+ * @brief Find first separator (LRE_SEP_POSITIVE or LRE_SEP_NEGATIVE)
+ * @param src Pointer to string
+ * @param size Size of string
+ * @return Pointer to separator or 0 if it was not found
+ */
+lre_decl
+const uint8_t *lrex_memsep(const uint8_t *src, size_t size) {
+	size_t i = 0;
+
+#if defined(LRE_SIMD)
+	if (size >= 16) {
+		i = lrex_kernels()->memsep(src, size);
+	}
+#endif
+
+	for (; i < size; i++) {
+		if (src[i] == LRE_SEP_POSITIVE || src[i] == LRE_SEP_NEGATIVE) {
+			return src + i;
+		}
+	}
+	
+	return 0;
+}
+
+
+/**
+ * @brief Mark every separator of string in one pass
+ * @param src Pointer to string
+ * @param size Size of string
+ * @param bits Bitmap of (size+63)/64 words. Bit (i%64) of word i/64 is set if src[i] is a separator
+ */
+lre_decl
+void lrex_sepmask(const uint8_t *src, size_t size, uint64_t *bits) {
+	size_t i = 0;
+
+#if defined(LRE_SIMD)
+	if (size >= 64) {
+		i = lrex_kernels()->sepmask(src, size, bits);
+	}
+#endif
+
+	for (; i < size; i++) {
+		if (i % 64 == 0) {
+			bits[i / 64] = 0;
+		}
+
+		if (src[i] == LRE_SEP_POSITIVE || src[i] == LRE_SEP_NEGATIVE) {
+			bits[i / 64] |= UINT64_C(1) << (i % 64);
+		}
+	}
+}
+
+
+/*
+ * Range kernels set check if some byte is out of [first, last]
+ * and return number of scanned bytes (multiple of the vector width).
+ * Both bounds must be ASCII: signed comparison rejects bytes above 0x7f.
+ */
+
+#if defined(LRE_SIMD_SSE2)
+lre_decl
+size_t lrex_range_sse2(const uint8_t *src, size_t size, uint8_t first, uint8_t last, int *check) {
+	const __m128i vfirst = _mm_set1_epi8((char) first);
+	const __m128i vlast  = _mm_set1_epi8((char) last);
+	__m128i acc = _mm_setzero_si128();
+	size_t  i   = 0;
+
+	for (; i + 16 <= size; i += 16) {
+		__m128i x = _mm_loadu_si128((const __m128i *) (src + i));
+
+		acc = _mm_or_si128(acc, _mm_or_si128(_mm_cmplt_epi8(x, vfirst), _mm_cmpgt_epi8(x, vlast)));
+	}
+
+	*check |= _mm_movemask_epi8(acc) != 0;
+	return i;
+}
+#endif
+
+
+#if defined(LRE_SIMD_AVX2)
+lre_decl LRE_TARGET_AVX2
+size_t lrex_range_avx2(const uint8_t *src, size_t size, uint8_t first, uint8_t last, int *check) {
+	const __m256i vfirst = _mm256_set1_epi8((char) first);
+	const __m256i vlast  = _mm256_set1_epi8((char) last);
+	__m256i acc = _mm256_setzero_si256();
+	size_t  i   = 0;
+
+	for (; i + 32 <= size; i += 32) {
+		__m256i x = _mm256_loadu_si256((const __m256i *) (src + i));
+
+		acc = _mm256_or_si256(acc, _mm256_or_si256(_mm256_cmpgt_epi8(vfirst, x), _mm256_cmpgt_epi8(x, vlast)));
+	}
+
+	*check |= _mm256_movemask_epi8(acc) != 0;
+	return i;
+}
+#endif
+
+
+#if defined(LRE_SIMD_NEON)
+lre_decl
+size_t lrex_range_neon(const uint8_t *src, size_t size, uint8_t first, uint8_t last, int *check) {
+	const uint8x16_t vfirst = vdupq_n_u8(first);
+	const uint8x16_t vlast  = vdupq_n_u8(last);
+	uint8x16_t acc = vdupq_n_u8(0);
+	uint8x8_t  half;
+	size_t     i = 0;
+
+	for (; i + 16 <= size; i += 16) {
+		uint8x16_t x = vld1q_u8(src + i);
+
+		acc = vorrq_u8(acc, vorrq_u8(vcltq_u8(x, vfirst), vcgtq_u8(x, vlast)));
+	}
+
+	half = vorr_u8(vget_low_u8(acc), vget_high_u8(acc));
+	*check |= vget_lane_u64(vreinterpret_u64_u8(half), 0) != 0;
+	return i;
+}
+#endif
+
+
+/**
+ * @brief Check that every byte of string is in [first, last]
+ * @param first First allowed ASCII character
+ * @param last Last allowed ASCII character
+ * @return LRE_OK if all bytes are in range, LRE_FAIL otherwise
+ */
+lre_decl
+int lrex_check_range(const uint8_t *src, size_t size, uint8_t first, uint8_t last) {
+	size_t i = 0;
+	int    check = 0;
+
+#if defined(LRE_SIMD)
+	if (size >= 16) {
+		i = lrex_kernels()->range(src, size, first, last, &check);
+	}
+#endif
+
+	for (; i < size; i++) {
+		check |= src[i] < first || src[i] > last;
+	}
+
+	return check ? LRE_FAIL : LRE_OK;
+}
+
+
+/*
+ * Runtime dispatch.
+ * Active kernels are chosen once, at the first call of any kernel.
+ * Like everything in this header, the choice is local to translation unit.
+ */
+
+static const lre_kernels_t lrex_kernels_scalar = {
+	LRE_ISA_SCALAR,
+	&lrex_write_str_scalar,
+	&lrex_read_str_scalar,
+	&lrex_memsep_scalar,
+	&lrex_sepmask_scalar,
+	&lrex_range_scalar
+};
+
+#if defined(LRE_SIMD_SSE2)
+static const lre_kernels_t lrex_kernels_sse2 = {
+	LRE_ISA_SSE2,
+	&lrex_write_str_sse2,
+	&lrex_read_str_sse2,
+	&lrex_memsep_sse2,
+	&lrex_sepmask_sse2,
+	&lrex_range_sse2
+};
+#endif
+
+#if defined(LRE_SIMD_AVX2)
+static const lre_kernels_t lrex_kernels_avx2 = {
+	LRE_ISA_AVX2,
+	&lrex_write_str_avx2,
+	&lrex_read_str_avx2,
+	&lrex_memsep_avx2,
+	&lrex_sepmask_avx2,
+	&lrex_range_avx2
+};
+#endif
+
+#if defined(LRE_SIMD_NEON)
+static const lre_kernels_t lrex_kernels_neon = {
+	LRE_ISA_NEON,
+	&lrex_write_str_neon,
+	&lrex_read_str_neon,
+	&lrex_memsep_neon,
+	&lrex_sepmask_neon,
+	&lrex_range_neon
+};
+#endif
+
+static const lre_kernels_t *lrex_kernels_active = 0;
+
+/* Kernels may be selected by several threads at once */
+#if defined(__GNUC__) || defined(__clang__)
+	#define lrex_kernels_load()   __atomic_load_n(&lrex_kernels_active, __ATOMIC_ACQUIRE)
+	#define lrex_kernels_store(k) __atomic_store_n(&lrex_kernels_active, (k), __ATOMIC_RELEASE)
+#else
+	#define lrex_kernels_load()   (*(const lre_kernels_t *volatile *) &lrex_kernels_active)
+	#define lrex_kernels_store(k) (*(const lre_kernels_t *volatile *) &lrex_kernels_active = (k))
+#endif
+
+
+/**
+ * @brief Returns the best instruction set supported by CPU and OS
+ */
+lre_decl
+lre_isa_t lrex_isa_detect(void) {
+#if defined(LRE_SIMD_AVX2) && (defined(__GNUC__) || defined(__clang__))
+	__builtin_cpu_init();
+
+	if (__builtin_cpu_supports("avx2")) {
+		return LRE_ISA_AVX2;
+	}
+#elif defined(LRE_SIMD_AVX2) && defined(_MSC_VER)
+	int regs[4];
+	__cpuid(regs, 0);
+
+	if (regs[0] >= 7) {
+		__cpuid(regs, 1);
+
+		/* OSXSAVE and AVX, then YMM state is enabled by OS */
+		if ((regs[2] & (1 << 27)) && (regs[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6) {
+			__cpuidex(regs, 7, 0);
+
+			if (regs[1] & (1 << 5)) {
+				return LRE_ISA_AVX2;
+			}
+		}
+	}
+#endif
+
+#if defined(LRE_SIMD_SSE2)
+	return LRE_ISA_SSE2;
+#elif defined(LRE_SIMD_NEON)
+	return LRE_ISA_NEON;
+#else
+	return LRE_ISA_SCALAR;
+#endif
+}
+
+
+/**
+ * @brief Parse instruction set name: "scalar", "sse2", "avx2", "neon"
+ * @return Instruction set or LRE_ISA_AUTO for unknown names
+ */
+lre_decl
+lre_isa_t lrex_isa_by_name(const char *name) {
+	if (name) {
+		if (!strcmp(name, "scalar")) return LRE_ISA_SCALAR;
+		if (!strcmp(name, "sse2"))   return LRE_ISA_SSE2;
+		if (!strcmp(name, "avx2"))   return LRE_ISA_AVX2;
+		if (!strcmp(name, "neon"))   return LRE_ISA_NEON;
+	}
+
+	return LRE_ISA_AUTO;
+}
+
+
+lre_decl
+const lre_kernels_t *lrex_kernels_by_isa(lre_isa_t isa) {
+	switch (isa) {
+		case LRE_ISA_SCALAR:
+			return &lrex_kernels_scalar;
+#if defined(LRE_SIMD_SSE2)
+		case LRE_ISA_SSE2:
+			return &lrex_kernels_sse2;
+#endif
+#if defined(LRE_SIMD_AVX2)
+		case LRE_ISA_AVX2:
+			return (lrex_isa_detect() == LRE_ISA_AVX2) ? &lrex_kernels_avx2 : 0;
+#endif
+#if defined(LRE_SIMD_NEON)
+		case LRE_ISA_NEON:
+			return &lrex_kernels_neon;
+#endif
+		default:
+			return 0;
+	}
+}
+
+
+/**
+ * @brief Select kernels of instruction set
+ *
+ * LRE_ISA_AUTO takes instruction set from LRE_ISA environment variable
+ * ("scalar", "sse2", "avx2", "neon") or the best supported one.
+ *
+ * @param isa Instruction set
+ * @param error Pointer to lre_error_t or 0
+ * @return LRE_OK if success, LRE_FAIL if instruction set is not supported
+ */
+lre_decl
+int lre_set_isa(lre_isa_t isa, lre_error_t *error) {
+	const lre_kernels_t *kernels;
+
+	if (isa == LRE_ISA_AUTO) {
+		kernels = lrex_kernels_by_isa(lrex_isa_by_name(getenv("LRE_ISA")));
+
+		if (!kernels) {
+			kernels = lrex_kernels_by_isa(lrex_isa_detect());
+		}
+	}
+	else {
+		kernels = lrex_kernels_by_isa(isa);
+	}
+
+	if (lre_unlikely(!kernels)) {
+		return lre_fail(LRE_ERROR_RANGE, error);
+	}
+
+	lrex_kernels_store(kernels);
+	return LRE_OK;
+}
+
+
+/**
+ * @brief Returns instruction set of active kernels
+ */
+lre_decl
+lre_isa_t lre_get_isa(void) {
+	return lrex_kernels()->isa;
+}
+
+
+lre_decl
+const lre_kernels_t *lrex_kernels(void) {
+	const lre_kernels_t *kernels = lrex_kernels_load();
+
+	if (lre_unlikely(!kernels)) {
+		lre_set_isa(LRE_ISA_AUTO, 0);
+		kernels = lrex_kernels_load();
+	}
+
+	return kernels;
+}
+
+/*
+ * */
+typedef struct {
+	const uint8_t *src; /* Pointer to first character */
+	const uint8_t *end; /* Pointer to next to last character */
+} lre_slice_t;
+
+
+/**
+ * @brief Returns length of slice
+ * @param slice Pointer to lre_slice_t object
+ */
+lre_decl
+ptrdiff_t lre_slice_len(const lre_slice_t *slice) {
+	return slice->end - slice->src;
+}
+
+
+/**
+ * @brief Returns last byte and shifts end of slice
+ * @param slice Pointer to lre_slice_t object
+ */
+lre_decl
+uint8_t lre_slice_pop(lre_slice_t *slice) {
+	return *(--slice->end);
+}
+
+
+/**
+ * @brief Returns number of bytes of decoded string
+ * @param slice Pointer to lre_slice_t object (from handler_str)
+ * @param enc String encoding (from handler_str)
+ */
+lre_decl
+size_t lre_slice_str_nbytes(const lre_slice_t *slice, lre_enc_t enc) {
+	if (lrex_enc_is_dense(enc)) {
+		return lrex_dense_nbytes(lre_slice_len(slice));
+	}
+
+	if (lrex_enc_is_bin(enc)) {
+		return lrex_bin_str_nbytes(slice->src, lre_slice_len(slice));
+	}
+
+	return lre_slice_len(slice) / 2;
+}
+
+
+/**
+ * @brief Decode string of any encoding. Shifts start of slice
+ * @param slice Pointer to lre_slice_t object (from handler_str)
+ * @param dst Destination with at least lre_slice_str_nbytes() of space
+ * @param enc String encoding (from handler_str)
+ * @return LRE_OK if success, LRE_FAIL if string contains invalid characters
+ */
+lre_decl
+int lre_slice_read_str(lre_slice_t *slice, uint8_t *dst, lre_enc_t enc) {
+	if (lrex_enc_is_dense(enc)) {
+		return lrex_read_dense(&slice->src, dst, lre_slice_len(slice), 0);
+	}
+
+	if (lrex_enc_is_bin(enc)) {
+		return lrex_read_bin_str(&slice->src, dst, lre_slice_len(slice));
+	}
+
+	return lrex_read_str_checked(&slice->src, dst, lre_slice_len(slice) / 2, 0);
+}
+
+
+/* LRE MEMORY ALLOCATOR.
+ * realloc_fn must accept null pointer like realloc(). */
+typedef struct {
+	void *(*malloc_fn) (void *ctx, size_t size);
+	void *(*realloc_fn)(void *ctx, void *ptr, size_t size);
+	void  (*free_fn)   (void *ctx, void *ptr);
+	void   *ctx;
+} lre_allocator_t;
+
+
+lre_decl
+void *lre_allocator_std_malloc(void *ctx, size_t size) {
+	return lre_std_malloc(size);
+}
+
+
+lre_decl
+void *lre_allocator_std_realloc(void *ctx, void *ptr, size_t size) {
+	return lre_std_realloc(ptr, size);
+}
+
+
+lre_decl
+void lre_allocator_std_free(void *ctx, void *ptr) {
+	lre_std_free(ptr);
+}
+
+
+/* Allocator of lre_std_* functions */
+static const lre_allocator_t lre_allocator_std = {
+	&lre_allocator_std_malloc,
+	&lre_allocator_std_realloc,
+	&lre_allocator_std_free,
+	0
+};
+
+
+/* LRE MEMORY BUFFER.
+ * Normally, it is long-lived objects in one thread. */
+typedef struct {
+	uint8_t *data;     /* Payload */
+	size_t   size;     /* Payload length */
+	size_t   capacity; /* Total *data allocated space  */
+	size_t   reserved; /* Minimal *data allocated space */
+
+	const lre_allocator_t *allocator; /* Memory allocator of buffer and *data */
+	unsigned growth;                  /* Growth of capacity in percent */
+	unsigned shrink_after;            /* Number of consecutive small resets before shrink */
+	unsigned small_resets;            /* Current number of consecutive small resets */
+} lre_buffer_t;
+
+
+/**
+ * @brief Reallocate memory.
+ * @param buf Pointer to lre_buffer_t
+ * @param capacity New capacity of buffer
+ * @param error Pointer to lre_error_t or 0
+ * @return LRE_OK if success, LRE_FAIL otherwise
+ */
+lre_decl
+int lre_buffer_reallocate(lre_buffer_t *buf, size_t capacity, lre_error_t *error) {
+	lre_debug("%i reserved=%i size=%i\n", (int) capacity, (int) buf->reserved, (int) buf->size);
+
+	if (lre_unlikely(capacity < buf->reserved)) {
+		capacity = buf->reserved;
+	}
+
+	if (lre_unlikely(capacity < buf->size)) {
+		return lre_fail(LRE_ERROR_ALLOCATION_SMALL, error);
+	}
+
+	{
+		const lre_allocator_t *allocator = buf->allocator;
+		uint8_t *data = allocator->realloc_fn(allocator->ctx, buf->data, capacity);
 
 		if (lre_unlikely(!data)) {
 			return lre_fail(LRE_ERROR_ALLOCATION, error);
 		}
 
-		buf->data = data;
-		buf->capacity = capacity;
+		buf->data = data;
+		buf->capacity = capacity;
+	}
+
+	return LRE_OK;
+}
+
+
+/**
+ * @brief Set growth and shrink policy of buffer.
+ * @param buf Pointer to lre_buffer_t
+ * @param growth Growth of capacity in percent. Values below 100 mean exact growth
+ * @param shrink_after Number of consecutive resets with size below reserved space
+ * before memory is shrunk to reserved space. 0 means shrink on every reset
+ */
+lre_decl
+void lre_buffer_set_policy(lre_buffer_t *buf, unsigned growth, unsigned shrink_after) {
+	buf->growth       = (growth < 100) ? 100 : growth;
+	buf->shrink_after = shrink_after;
+	buf->small_resets = 0;
+}
+
+
+/**
+ * @brief Initialize buffer object that is allocated by caller.
+ * @param buf Pointer to lre_buffer_t
+ * @param reserve Reserved space. Always incremented by 1
+ * @param allocator Pointer to lre_allocator_t of buffer data
+ * @param error Pointer to lre_error_t or 0
+ * @return LRE_OK if success, LRE_FAIL otherwise
+ */
+lre_decl
+int lrex_buffer_init(lre_buffer_t *buf, size_t reserve, const lre_allocator_t *allocator, lre_error_t *error) {
+	memset(buf, 0, sizeof(lre_buffer_t));
+	buf->allocator = allocator;
+	lre_buffer_set_policy(buf, LRE_BUFFER_GROWTH, LRE_BUFFER_SHRINK_AFTER);
+
+	reserve++;
+
+	if (lre_unlikely(lre_buffer_reallocate(buf, reserve, error) != LRE_OK)) {
+		return LRE_FAIL;
+	}
+
+	buf->data[0] = '\0';
+	buf->reserved = reserve;
+	buf->capacity = reserve;
+
+	return LRE_OK;
+}
+
+
+/**
+ * @brief Create buffer instance with reserved memory and custom allocator.
+ * The buffer memory is always terminated with an extra null character.
+ * @param reserve Reserved space. Always incremented by 1
+ * @param allocator Pointer to lre_allocator_t or 0 for lre_std_* functions. Must outlive buffer
+ * @param error Pointer to lre_error_t or 0
+ * @return Pointer to lre_buffer_t instance if success, 0 otherwise
+ */
+lre_decl
+lre_buffer_t *lre_buffer_create_ex(size_t reserve, const lre_allocator_t *allocator, lre_error_t *error) {
+	lre_buffer_t *buf;
+
+	if (!allocator) {
+		allocator = &lre_allocator_std;
+	}
+
+	buf = allocator->malloc_fn(allocator->ctx, sizeof(lre_buffer_t));
+
+	if (lre_unlikely(!buf)) {
+		lre_fail(LRE_ERROR_ALLOCATION, error);
+		return 0;
+	}
+
+	if (lre_unlikely(lrex_buffer_init(buf, reserve, allocator, error) != LRE_OK)) {
+		allocator->free_fn(allocator->ctx, buf);
+		return 0;
+	}
+
+	return buf;
+}
+
+
+/**
+ * @brief Create buffer instance with reserved memory. The buffer memory is always terminated with an extra null character.
+ * @param reserve Reserved space. Always incremented by 1
+ * @param error Pointer to lre_error_t or 0
+ * @return Pointer to lre_buffer_t instance if success, 0 otherwise
+ */
+lre_decl
+lre_buffer_t *lre_buffer_create(size_t reserve, lre_error_t *error) {
+	return lre_buffer_create_ex(reserve, 0, error);
+}
+
+
+/**
+ * @brief If available capacity < required, allocate additional memory.
+ * Capacity grows geometrically according to buffer policy.
+ * @param buf Pointer to lre_buffer_t
+ * @param required Required memory
+ * @param error Pointer to lre_error_t or 0
+ * @return LRE_OK if success, LRE_FAIL otherwise
+ */
+lre_decl
+int lre_buffer_require(lre_buffer_t *buf, size_t required, lre_error_t *error) {
+	size_t capacity = buf->size + required + 1;
+
+	if (lre_unlikely(capacity > buf->capacity)) {
+		size_t grown = buf->capacity / 100 * buf->growth + buf->capacity % 100 * buf->growth / 100;
+
+		if (grown > capacity) {
+			capacity = grown;
+		}
+
+		return lre_buffer_reallocate(buf, capacity, error);
+	}
+
+	return LRE_OK;
+}
+
+
+/**
+ * @brief Returns pointer to next to last character.
+ *
+ * This call is mostly used for write to end of buffer.
+ * Returned pointer is invalidated after calls lre_buffer_reset(), lre_buffer_require(), lre_buffer_close().
+ *
+ * @param buf Pointer to lre_buffer_t
+ */
+lre_decl
+uint8_t *lre_buffer_end(lre_buffer_t *buf) {
+	return buf->data + buf->size;
+}
+
+
+/**
+ * @brief Set size to pointer offset distance and terminate buffer with a null character.
+ * @param buf Pointer to lre_buffer_t
+ * @param end Pointer to buffer data (tupically from lre_buffer_end())
+ * @return LRE_OK if success, LRE_FAIL otherwise
+ */
+lre_decl
+void lre_buffer_set_size_distance(lre_buffer_t *buf, const uint8_t *end) {
+	lre_debug("Zero at %i\n", (int) (end - buf->data + 1));
+
+	if (lre_likely(end >= buf->data)) {
+		buf->size = end - buf->data;
+		buf->data[buf->size] = '\0';
+	}
+}
+
+
+/**
+ * @brief Fast version of lre_buffer_reset without memory reallocations.
+ * @param buf Pointer to lre_buffer_t
+ */
+lre_decl
+void lre_buffer_reset_fast(lre_buffer_t *buf) {
+	buf->size = 0;
+	buf->data[0] = '\0';
+}
+
+
+/**
+ * @brief Reset size to 0 and terminate buffer with a null character.
+ * Memory is shrunk to reserved space after buf->shrink_after consecutive
+ * resets of data that fits into reserved space.
+ * @param buf Pointer to lre_buffer_t
+ * @param error Pointer to lre_error_t or 0
+ * @return LRE_OK if success, LRE_FAIL otherwise
+ */
+lre_decl
+int lre_buffer_reset(lre_buffer_t *buf, lre_error_t *error) {
+	size_t size = buf->size;
+
+	lre_buffer_reset_fast(buf);
+
+	if (lre_unlikely(buf->capacity != buf->reserved)) {
+		if (buf->shrink_after) {
+			if (size >= buf->reserved) {
+				buf->small_resets = 0;
+				return LRE_OK;
+			}
+
+			if (++buf->small_resets < buf->shrink_after) {
+				return LRE_OK;
+			}
+
+			buf->small_resets = 0;
+		}
+
+		return lre_buffer_reallocate(buf, buf->reserved, error);
+	}
+	
+	return LRE_OK;
+}
+
+/**
+ * @brief Free all buffer memory
+ * @param buf Pointer to lre_buffer_t
+ */
+lre_decl
+void lre_buffer_close(lre_buffer_t *buf) {
+	lre_debug("%p\n", buf);
+
+	if (buf) {
+		const lre_allocator_t *allocator = buf->allocator;
+
+		allocator->free_fn(allocator->ctx, buf->data);
+		allocator->free_fn(allocator->ctx, buf);
+	}
+}
+
+
+/* LRE ARENA.
+ * Bump allocator for many short-lived buffers. Memory is taken from large
+ * chunks and released at once by lre_arena_reset() or lre_arena_close().
+ * Every block is preceded by its size, the last block grows in place. */
+typedef struct lre_arena_chunk_t {
+	struct lre_arena_chunk_t *next;
+	size_t size; /* Size of chunk data */
+	size_t used; /* Used bytes of chunk data */
+} lre_arena_chunk_t;
+
+
+typedef struct {
+	lre_allocator_t        allocator;  /* Allocator of arena blocks, ctx is arena */
+	const lre_allocator_t *backing;    /* Allocator of chunks */
+	lre_arena_chunk_t     *chunks;     /* All chunks */
+	lre_arena_chunk_t     *current;    /* Chunk of next allocation */
+	uint8_t               *last;       /* Last allocated block */
+	size_t                 chunk_size; /* Minimal size of chunk data */
+} lre_arena_t;
+
+
+/* */
+lre_decl
+size_t lrex_arena_round(size_t size) {
+	return (size + (LRE_ARENA_ALIGN - 1)) & ~(size_t) (LRE_ARENA_ALIGN - 1);
+}
+
+
+/**
+ * @brief Returns pointer to data of chunk
+ */
+lre_decl
+uint8_t *lrex_arena_chunk_data(lre_arena_chunk_t *chunk) {
+	return (uint8_t *) chunk + lrex_arena_round(sizeof(lre_arena_chunk_t));
+}
+
+
+/**
+ * @brief Make current the next chunk with at least need bytes, allocate it if required
+ * @return Pointer to chunk if success, 0 otherwise
+ */
+lre_decl
+lre_arena_chunk_t *lrex_arena_next_chunk(lre_arena_t *arena, size_t need) {
+	lre_arena_chunk_t *next = arena->current ? arena->current->next : arena->chunks;
+	lre_arena_chunk_t *chunk;
+	size_t size = (need > arena->chunk_size) ? need : arena->chunk_size;
+
+	if (next && next->size >= need) {
+		next->used = 0;
+		arena->current = next;
+		return next;
+	}
+
+	chunk = arena->backing->malloc_fn(arena->backing->ctx, lrex_arena_round(sizeof(lre_arena_chunk_t)) + size);
+
+	if (lre_unlikely(!chunk)) {
+		return 0;
+	}
+
+	chunk->size = size;
+	chunk->used = 0;
+
+	/* Chunks that follow current one are unused since reset, too small one is replaced */
+	if (next) {
+		chunk->next = next->next;
+		arena->backing->free_fn(arena->backing->ctx, next);
+	}
+	else {
+		chunk->next = 0;
+	}
+
+	if (arena->current) {
+		arena->current->next = chunk;
+	}
+	else {
+		arena->chunks = chunk;
+	}
+
+	arena->current = chunk;
+	return chunk;
+}
+
+
+/**
+ * @brief Allocate block from arena
+ * @return Pointer to block if success, 0 otherwise
+ */
+lre_decl
+void *lre_arena_malloc(void *ctx, size_t size) {
+	lre_arena_t       *arena = (lre_arena_t *) ctx;
+	lre_arena_chunk_t *chunk = arena->current;
+	size_t             need  = LRE_ARENA_ALIGN + lrex_arena_round(size);
+	uint8_t           *block;
+
+	if (lre_unlikely(!chunk || chunk->size - chunk->used < need)) {
+		if (lre_unlikely(!(chunk = lrex_arena_next_chunk(arena, need)))) {
+			return 0;
+		}
+	}
+
+	block = lrex_arena_chunk_data(chunk) + chunk->used;
+	chunk->used += need;
+
+	*(size_t *) block = size;
+	arena->last = block + LRE_ARENA_ALIGN;
+
+	return arena->last;
+}
+
+
+/**
+ * @brief Reallocate block of arena. The last block is resized in place
+ * @return Pointer to block if success, 0 otherwise
+ */
+lre_decl
+void *lre_arena_realloc(void *ctx, void *ptr, size_t size) {
+	lre_arena_t *arena = (lre_arena_t *) ctx;
+	uint8_t     *block = (uint8_t *) ptr;
+	size_t       nbytes;
+
+	if (!block) {
+		return lre_arena_malloc(ctx, size);
+	}
+
+	nbytes = *(size_t *) (block - LRE_ARENA_ALIGN);
+
+	if (block == arena->last) {
+		lre_arena_chunk_t *chunk  = arena->current;
+		size_t             offset = block - lrex_arena_chunk_data(chunk);
+
+		if (chunk->size - offset >= lrex_arena_round(size)) {
+			chunk->used = offset + lrex_arena_round(size);
+			*(size_t *) (block - LRE_ARENA_ALIGN) = size;
+			return block;
+		}
+	}
+	else if (size <= nbytes) {
+		return block;
+	}
+
+	{
+		uint8_t *data = lre_arena_malloc(ctx, size);
+
+		if (lre_likely(data)) {
+			memcpy(data, block, (nbytes < size) ? nbytes : size);
+		}
+
+		return data;
+	}
+}
+
+
+/**
+ * @brief Free block of arena. Only the last block is really released
+ */
+lre_decl
+void lre_arena_free(void *ctx, void *ptr) {
+	lre_arena_t *arena = (lre_arena_t *) ctx;
+
+	if (ptr && ptr == arena->last) {
+		arena->current->used = (uint8_t *) ptr - LRE_ARENA_ALIGN - lrex_arena_chunk_data(arena->current);
+		arena->last = 0;
+	}
+}
+
+
+/**
+ * @brief Create arena instance.
+ * @param chunk_size Minimal size of chunk or 0 for LRE_ARENA_CHUNK
+ * @param backing Pointer to lre_allocator_t of chunks or 0 for lre_std_* functions
+ * @param error Pointer to lre_error_t or 0
+ * @return Pointer to lre_arena_t instance if success, 0 otherwise
+ */
+lre_decl
+lre_arena_t *lre_arena_create(size_t chunk_size, const lre_allocator_t *backing, lre_error_t *error) {
+	lre_arena_t *arena;
+
+	if (!backing) {
+		backing = &lre_allocator_std;
+	}
+
+	arena = backing->malloc_fn(backing->ctx, sizeof(lre_arena_t));
+
+	if (lre_unlikely(!arena)) {
+		lre_fail(LRE_ERROR_ALLOCATION, error);
+		return 0;
+	}
+
+	memset(arena, 0, sizeof(lre_arena_t));
+
+	arena->allocator.malloc_fn  = &lre_arena_malloc;
+	arena->allocator.realloc_fn = &lre_arena_realloc;
+	arena->allocator.free_fn    = &lre_arena_free;
+	arena->allocator.ctx        = arena;
+
+	arena->backing    = backing;
+	arena->chunk_size = chunk_size ? chunk_size : LRE_ARENA_CHUNK;
+
+	return arena;
+}
+
+
+/**
+ * @brief Create buffer instance in arena. The buffer works with every lre_pack_* function
+ * and is released by lre_arena_reset() or lre_arena_close(), lre_buffer_close() is optional.
+ * @param arena Pointer to lre_arena_t
+ * @param reserve Reserved space. Always incremented by 1
+ * @param error Pointer to lre_error_t or 0
+ * @return Pointer to lre_buffer_t instance if success, 0 otherwise
+ */
+lre_decl
+lre_buffer_t *lre_arena_buffer(lre_arena_t *arena, size_t reserve, lre_error_t *error) {
+	return lre_buffer_create_ex(reserve, &arena->allocator, error);
+}
+
+
+/**
+ * @brief Release all blocks in O(1). Chunks are kept for reuse.
+ * All buffers of arena are invalidated.
+ * @param arena Pointer to lre_arena_t
+ */
+lre_decl
+void lre_arena_reset(lre_arena_t *arena) {
+	arena->current = arena->chunks;
+	arena->last    = 0;
+
+	if (arena->current) {
+		arena->current->used = 0;
+	}
+}
+
+
+/**
+ * @brief Free all arena memory. All buffers of arena are invalidated.
+ * @param arena Pointer to lre_arena_t
+ */
+lre_decl
+void lre_arena_close(lre_arena_t *arena) {
+	if (arena) {
+		const lre_allocator_t *backing = arena->backing;
+		lre_arena_chunk_t *chunk = arena->chunks;
+
+		while (chunk) {
+			lre_arena_chunk_t *next = chunk->next;
+
+			backing->free_fn(backing->ctx, chunk);
+			chunk = next;
+		}
+
+		backing->free_fn(backing->ctx, arena);
+	}
+}
+
+
+#if defined(LRE_POOL)
+/* LRE BUFFER POOL.
+ * Buffers are acquired and released from any thread without malloc.
+ * Released buffers go to the thread cache, its overflow goes to global
+ * lock-free lists. Buffers are bucketed by capacity. */
+typedef struct lre_pool_node_t {
+	lre_buffer_t            buffer;   /* Must be first */
+	struct lre_pool_node_t *next;     /* Link of free list */
+	struct lre_pool_node_t *all_next; /* Link of list of all nodes */
+} lre_pool_node_t;
+
+
+/* Statistics of buffer pool */
+typedef struct {
+	size_t hits;   /* Acquired from thread cache or global list */
+	size_t misses; /* Allocated */
+} lre_buffer_pool_stats_t;
+
+
+typedef struct {
+	const lre_allocator_t *allocator;              /* Thread-safe allocator of buffers */
+	const void            *origin;                 /* Translation unit that created pool (see id) */
+	size_t                 id;                     /* Identifier of pool within origin */
+	lre_pool_node_t       *free[LRE_POOL_BUCKETS]; /* Global free lists (push or take all) */
+	lre_pool_node_t       *all;                    /* All nodes (push only) */
+	lre_buffer_pool_stats_t stats;                 /* Flushed statistics of thread caches */
+} lre_buffer_pool_t;
+
+
+/* Thread cache of one pool. Pool is identified by origin and id,
+ * not by address only: address of closed pool may be reused. */
+typedef struct {
+	lre_buffer_pool_t      *pool;                    /* 0 if cache is unused */
+	const void             *origin;
+	size_t                  id;
+	size_t                  used;                    /* Tick of the last use */
+	lre_pool_node_t        *head[LRE_POOL_BUCKETS];
+	unsigned                count[LRE_POOL_BUCKETS];
+	lre_buffer_pool_stats_t stats;                   /* Not flushed yet */
+} lrex_pool_cache_t;
+
+
+static LRE_THREAD_LOCAL lrex_pool_cache_t lrex_pool_caches[LRE_POOL_THREAD_CACHES];
+static LRE_THREAD_LOCAL size_t lrex_pool_ticks = 0;
+
+/* Pool id is unique within translation unit, address of the counter tells units apart */
+static size_t lrex_pool_ids = 0;
+
+
+#if defined(LRE_ATOMIC_GNU)
+lre_decl
+lre_pool_node_t *lrex_pool_load(lre_pool_node_t **head) {
+	return __atomic_load_n(head, __ATOMIC_ACQUIRE);
+}
+
+
+lre_decl
+lre_pool_node_t *lrex_pool_exchange(lre_pool_node_t **head, lre_pool_node_t *node) {
+	return __atomic_exchange_n(head, node, __ATOMIC_ACQ_REL);
+}
+
+
+lre_decl
+int lrex_pool_cas(lre_pool_node_t **head, lre_pool_node_t **expected, lre_pool_node_t *node) {
+	return __atomic_compare_exchange_n(head, expected, node, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+}
+
+
+lre_decl
+size_t lrex_pool_increment(size_t *counter) {
+	return __atomic_add_fetch(counter, 1, __ATOMIC_RELAXED);
+}
+
+
+lre_decl
+void lrex_pool_add(size_t *counter, size_t value) {
+	__atomic_add_fetch(counter, value, __ATOMIC_RELAXED);
+}
+
+
+lre_decl
+size_t lrex_pool_counter(const size_t *counter) {
+	return __atomic_load_n(counter, __ATOMIC_RELAXED);
+}
+#else
+lre_decl
+lre_pool_node_t *lrex_pool_load(lre_pool_node_t **head) {
+	return *(lre_pool_node_t *volatile *) head;
+}
+
+
+lre_decl
+lre_pool_node_t *lrex_pool_exchange(lre_pool_node_t **head, lre_pool_node_t *node) {
+	return (lre_pool_node_t *) _InterlockedExchangePointer((void *volatile *) head, node);
+}
+
+
+lre_decl
+int lrex_pool_cas(lre_pool_node_t **head, lre_pool_node_t **expected, lre_pool_node_t *node) {
+	lre_pool_node_t *prev = (lre_pool_node_t *) _InterlockedCompareExchangePointer((void *volatile *) head, node, *expected);
+
+	if (prev == *expected) {
+		return 1;
+	}
+
+	*expected = prev;
+	return 0;
+}
+
+
+lre_decl
+size_t lrex_pool_increment(size_t *counter) {
+#if defined(_WIN64)
+	return (size_t) _InterlockedIncrement64((volatile __int64 *) counter);
+#else
+	return (size_t) _InterlockedIncrement((volatile long *) counter);
+#endif
+}
+
+
+lre_decl
+void lrex_pool_add(size_t *counter, size_t value) {
+#if defined(_WIN64)
+	_InterlockedExchangeAdd64((volatile __int64 *) counter, (__int64) value);
+#else
+	_InterlockedExchangeAdd((volatile long *) counter, (long) value);
+#endif
+}
+
+
+lre_decl
+size_t lrex_pool_counter(const size_t *counter) {
+	return *(const volatile size_t *) counter;
+}
+#endif
+
+
+/**
+ * @brief Push chain of nodes (first..last linked by next) to global free list
+ */
+lre_decl
+void lrex_pool_push(lre_pool_node_t **head, lre_pool_node_t *first, lre_pool_node_t *last) {
+	lre_pool_node_t *expected = lrex_pool_load(head);
+
+	do {
+		last->next = expected;
+	} while (!lrex_pool_cas(head, &expected, first));
+}
+
+
+/**
+ * @brief Push node to list of all nodes
+ */
+lre_decl
+void lrex_pool_push_all(lre_pool_node_t **head, lre_pool_node_t *node) {
+	lre_pool_node_t *expected = lrex_pool_load(head);
+
+	do {
+		node->all_next = expected;
+	} while (!lrex_pool_cas(head, &expected, node));
+}
+
+
+/**
+ * @brief Returns the smallest bucket with capacity for required bytes (and null character)
+ */
+lre_decl
+int lrex_pool_bucket_ceil(size_t required) {
+	int b = 0;
+
+	while (b < LRE_POOL_BUCKETS - 1 && ((size_t) LRE_POOL_MIN << b) < required + 1) {
+		b++;
+	}
+
+	return b;
+}
+
+
+/**
+ * @brief Returns the largest bucket that capacity satisfies
+ */
+lre_decl
+int lrex_pool_bucket_floor(size_t capacity) {
+	int b = 0;
+
+	while (b < LRE_POOL_BUCKETS - 1 && ((size_t) LRE_POOL_MIN << (b + 1)) <= capacity) {
+		b++;
+	}
+
+	return b;
+}
+
+
+/**
+ * @brief Move buffers and statistics of thread cache to its pool and unbind cache
+ */
+lre_decl
+void lrex_pool_cache_flush(lrex_pool_cache_t *cache) {
+	lre_buffer_pool_t *pool = cache->pool;
+	int b;
+
+	for (b = 0; b < LRE_POOL_BUCKETS; b++) {
+		lre_pool_node_t *first = cache->head[b];
+
+		if (first) {
+			lre_pool_node_t *last = first;
+
+			while (last->next) {
+				last = last->next;
+			}
+
+			lrex_pool_push(&pool->free[b], first, last);
+		}
+	}
+
+	if (cache->stats.hits) {
+		lrex_pool_add(&pool->stats.hits, cache->stats.hits);
+	}
+
+	if (cache->stats.misses) {
+		lrex_pool_add(&pool->stats.misses, cache->stats.misses);
+	}
+
+	memset(cache, 0, sizeof(lrex_pool_cache_t));
+}
+
+
+/**
+ * @brief Returns thread cache of pool, or 0 if thread has no cache of pool
+ */
+lre_decl
+lrex_pool_cache_t *lrex_pool_cache_find(const lre_buffer_pool_t *pool) {
+	int i;
+
+	for (i = 0; i < LRE_POOL_THREAD_CACHES; i++) {
+		lrex_pool_cache_t *cache = &lrex_pool_caches[i];
+
+		if (cache->pool == pool && cache->id == pool->id && cache->origin == pool->origin) {
+			return cache;
+		}
+	}
+
+	return 0;
+}
+
+
+/**
+ * @brief Returns thread cache of pool. If all caches are in use, the least
+ * recently used one is flushed to its pool and bound to this pool.
+ */
+lre_decl
+lrex_pool_cache_t *lrex_pool_cache_get(lre_buffer_pool_t *pool) {
+	lrex_pool_cache_t *cache = lrex_pool_cache_find(pool);
+
+	if (lre_unlikely(!cache)) {
+		int i;
+
+		cache = &lrex_pool_caches[0];
+
+		for (i = 0; i < LRE_POOL_THREAD_CACHES && cache->pool; i++) {
+			if (!lrex_pool_caches[i].pool || lrex_pool_caches[i].used < cache->used) {
+				cache = &lrex_pool_caches[i];
+			}
+		}
+
+		if (cache->pool) {
+			lrex_pool_cache_flush(cache);
+		}
+
+		cache->pool   = pool;
+		cache->origin = pool->origin;
+		cache->id     = pool->id;
+	}
+
+	cache->used = ++lrex_pool_ticks;
+	return cache;
+}
+
+
+/**
+ * @brief Take a chain of free buffers of bucket from global list: at most
+ * LRE_POOL_CACHE of them go to thread cache, the rest is pushed back.
+ */
+lre_decl
+void lrex_pool_refill(lre_buffer_pool_t *pool, lrex_pool_cache_t *cache, int b) {
+	/* Global list is taken as a whole, so popping has no ABA problem */
+	lre_pool_node_t *first = lrex_pool_exchange(&pool->free[b], 0);
+	lre_pool_node_t *last  = first;
+	unsigned         count = 1;
+
+	if (!first) {
+		return;
+	}
+
+	while (last->next && count < LRE_POOL_CACHE) {
+		last = last->next;
+		count++;
+	}
+
+	if (last->next) {
+		lre_pool_node_t *rest = last->next;
+		lre_pool_node_t *rest_last = rest;
+
+		while (rest_last->next) {
+			rest_last = rest_last->next;
+		}
+
+		lrex_pool_push(&pool->free[b], rest, rest_last);
+	}
+
+	last->next = cache->head[b];
+	cache->head[b] = first;
+	cache->count[b] += count;
+}
+
+
+/**
+ * @brief Create buffer pool instance.
+ * @param allocator Pointer to thread-safe lre_allocator_t or 0 for lre_std_* functions
+ * @param error Pointer to lre_error_t or 0
+ * @return Pointer to lre_buffer_pool_t instance if success, 0 otherwise
+ */
+lre_decl
+lre_buffer_pool_t *lre_buffer_pool_create(const lre_allocator_t *allocator, lre_error_t *error) {
+	lre_buffer_pool_t *pool;
+
+	if (!allocator) {
+		allocator = &lre_allocator_std;
+	}
+
+	pool = allocator->malloc_fn(allocator->ctx, sizeof(lre_buffer_pool_t));
+
+	if (lre_unlikely(!pool)) {
+		lre_fail(LRE_ERROR_ALLOCATION, error);
+		return 0;
+	}
+
+	memset(pool, 0, sizeof(lre_buffer_pool_t));
+	pool->allocator = allocator;
+	pool->origin = &lrex_pool_ids;
+	pool->id = lrex_pool_increment(&lrex_pool_ids);
+
+	return pool;
+}
+
+
+/**
+ * @brief Acquire empty buffer with at least required capacity. Any thread.
+ * The buffer must be returned by lre_buffer_pool_release(), never by lre_buffer_close().
+ * @param pool Pointer to lre_buffer_pool_t
+ * @param required Required capacity
+ * @param error Pointer to lre_error_t or 0
+ * @return Pointer to lre_buffer_t instance if success, 0 otherwise
+ */
+lre_decl
+lre_buffer_t *lre_buffer_pool_acquire(lre_buffer_pool_t *pool, size_t required, lre_error_t *error) {
+	lrex_pool_cache_t *cache  = lrex_pool_cache_get(pool);
+	int                bucket = lrex_pool_bucket_ceil(required);
+	lre_pool_node_t   *node;
+	int                b;
+
+	/* Larger buffers of thread cache serve smaller keys */
+	for (b = bucket; b < LRE_POOL_BUCKETS && !cache->head[b]; b++);
+
+	if (b == LRE_POOL_BUCKETS) {
+		b = bucket;
+
+		if (lrex_pool_load(&pool->free[b])) {
+			lrex_pool_refill(pool, cache, b);
+		}
+	}
+
+	node = cache->head[b];
+
+	/* Last bucket holds buffers of different capacity */
+	if (lre_likely(node && node->buffer.capacity > required)) {
+		cache->head[b] = node->next;
+		cache->count[b]--;
+		cache->stats.hits++;
+
+		lre_buffer_reset_fast(&node->buffer);
+		return &node->buffer;
+	}
+
+	cache->stats.misses++;
+	node = pool->allocator->malloc_fn(pool->allocator->ctx, sizeof(lre_pool_node_t));
+
+	if (lre_unlikely(!node)) {
+		lre_fail(LRE_ERROR_ALLOCATION, error);
+		return 0;
+	}
+
+	if (required < ((size_t) LRE_POOL_MIN << bucket)) {
+		required = ((size_t) LRE_POOL_MIN << bucket) - 1;
+	}
+
+	if (lre_unlikely(lrex_buffer_init(&node->buffer, required, pool->allocator, error) != LRE_OK)) {
+		pool->allocator->free_fn(pool->allocator->ctx, node);
+		return 0;
+	}
+
+	lrex_pool_push_all(&pool->all, node);
+	return &node->buffer;
+}
+
+
+/**
+ * @brief Return buffer that is acquired from pool. Any thread.
+ * @param pool Pointer to lre_buffer_pool_t
+ * @param buf Pointer to lre_buffer_t from lre_buffer_pool_acquire()
+ */
+lre_decl
+void lre_buffer_pool_release(lre_buffer_pool_t *pool, lre_buffer_t *buf) {
+	lrex_pool_cache_t *cache = lrex_pool_cache_get(pool);
+	lre_pool_node_t   *node  = (lre_pool_node_t *) buf;
+	int                bucket;
+
+	if (!buf) {
+		return;
+	}
+
+	/* Grown buffer keeps its capacity and serves larger keys */
+	buf->reserved = buf->capacity;
+	bucket = lrex_pool_bucket_floor(buf->capacity);
+
+	if (cache->count[bucket] < LRE_POOL_CACHE) {
+		node->next = cache->head[bucket];
+		cache->head[bucket] = node;
+		cache->count[bucket]++;
+		return;
+	}
+
+	node->next = 0;
+	lrex_pool_push(&pool->free[bucket], node, node);
+}
+
+
+/**
+ * @brief Move buffers and statistics of thread cache to pool, so other threads
+ * can acquire them. Every thread that used pool must call it before pool is closed.
+ * @param pool Pointer to lre_buffer_pool_t
+ */
+lre_decl
+void lre_buffer_pool_flush(lre_buffer_pool_t *pool) {
+	lrex_pool_cache_t *cache = lrex_pool_cache_find(pool);
+
+	if (cache) {
+		lrex_pool_cache_flush(cache);
+	}
+}
+
+
+/**
+ * @brief Get hit/miss statistics of pool. Statistics of thread cache are
+ * counted by pool when the cache is flushed.
+ * @param pool Pointer to lre_buffer_pool_t
+ * @param stats Pointer to lre_buffer_pool_stats_t (output)
+ */
+lre_decl
+void lre_buffer_pool_stats(const lre_buffer_pool_t *pool, lre_buffer_pool_stats_t *stats) {
+	stats->hits   = lrex_pool_counter(&pool->stats.hits);
+	stats->misses = lrex_pool_counter(&pool->stats.misses);
+}
+
+
+/**
+ * @brief Free all buffers of pool and pool itself. No thread may use pool,
+ * other threads must flush their caches before (see lre_buffer_pool_flush()).
+ * @param pool Pointer to lre_buffer_pool_t
+ */
+lre_decl
+void lre_buffer_pool_close(lre_buffer_pool_t *pool) {
+	if (pool) {
+		const lre_allocator_t *allocator = pool->allocator;
+		lre_pool_node_t *node;
+		lrex_pool_cache_t *cache = lrex_pool_cache_find(pool);
+
+		/* Thread cache of caller is dropped, its buffers are in the list of all nodes */
+		if (cache) {
+			memset(cache, 0, sizeof(lrex_pool_cache_t));
+		}
+
+		node = pool->all;
+
+		while (node) {
+			lre_pool_node_t *next = node->all_next;
+
+			allocator->free_fn(allocator->ctx, node->buffer.data);
+			allocator->free_fn(allocator->ctx, node);
+			node = next;
+		}
+
+		allocator->free_fn(allocator->ctx, pool);
+	}
+}
+#endif
+
+/*
+ *
+ */
+
+
+/* Extra space for writers that store whole words past the end of value */
+#define LRE_PACK_SLACK 16
+
+
+/* Max size of binary payload of double value: nbytes(2) + integral(128) + store slack(8) */
+#define LRE_FLOAT_PAYLOAD_MAX (2+128+8)
+
+
+/**
+ * @brief Split absolute value of finite double into integral and fraction parts.
+ * Only IEEE-754 bits and integer arithmetic are used.
+ * @param value Double value
+ * @param integral Integral part without trailing zero bytes (see return value)
+ * @param exponent Unbiased exponent of fraction part
+ * @param mantissa Fraction part as 53-bit mantissa, 0 if value is integer
+ * @return Number of zero bytes that follow integral, non-zero only for values >= 2^64
+ */
+lre_decl
+int lrex_float_split(double value, uint64_t *integral, int *exponent, uint64_t *mantissa) {
+	uint64_t bits;
+	uint64_t significand;
+	int      shift;
+
+	memcpy(&bits, &value, sizeof(bits));
+	significand = bits & UINT64_C(0x000fffffffffffff);
+	shift = (int) ((bits >> 52) & 0x7ff);
+
+	/* Subnormals have the scale of the lowest normal exponent */
+	if (lre_likely(shift)) {
+		significand |= UINT64_C(0x0010000000000000);
+	}
+	else {
+		shift = 1;
+	}
+
+	/* value = significand * 2^-shift */
+	shift = 1075 - shift;
+
+	*exponent = 0;
+	*mantissa = 0;
+
+	if (shift <= 0) {
+		int zeros = 0;
+
+		/* Keep integral in 64 bits, whole bytes of low zero bits are counted */
+		if (shift < -11) {
+			zeros = (-shift - 4) >> 3;
+			shift += zeros * 8;
+		}
+
+		*integral = significand << -shift;
+		return zeros;
+	}
+
+	if (shift < 53) {
+		*integral = significand >> shift;
+		significand &= (UINT64_C(1) << shift) - 1;
+	}
+	else {
+		*integral = 0;
+	}
+
+	if (significand) {
+		int nbits = lrex_log2i(significand) + 1;
+
+		*exponent = nbits - shift;
+		*mantissa = significand << (53 - nbits);
+	}
+
+	return 0;
+}
+
+
+/**
+ * @brief Number of bytes of 53-bit mantissa to write: 7, or less without trailing
+ * zero bytes if compact
+ * @param mantissa Mantissa. Must NOT be 0
+ * @param compact Non-zero for compact floats (see lre_pack_float_compact())
+ */
+lre_decl
+int lrex_mantissa_nbytes(uint64_t mantissa, int compact) {
+	return compact ? 7 - lrex_ctz64(mantissa) / 8 : 7;
+}
+
+
+/**
+ * @brief Check that split double value is out of 64-bit integer range (packed as BIG)
+ */
+lre_decl
+int lrex_float_is_big(uint64_t integral, int zeros, int negative) {
+	/* Negative range is one more: -9223372036854775808 */
+	return zeros || integral > UINT64_C(9223372036854775807) + (negative != 0);
+}
+
+
+/**
+ * @brief Write binary payload of finite double value (not complemented):
+ * integral + [exp(2) + mantissa(7)], or nbytes(2) + integral for big values
+ * @param dst Destination with LRE_FLOAT_PAYLOAD_MAX of space
+ * @param value Double value
+ * @param tag Numeric tag of value
+ * @param compact Non-zero for compact floats (see lre_pack_float_compact())
+ * @return Number of bytes
+ */
+lre_decl
+size_t lrex_float_payload(uint8_t *dst, double value, lre_tag_t *tag, int compact) {
+	int      negative = value < 0.0;
+	uint64_t integral;
+	int      integral_nbytes;
+	int      zeros;
+
+	int      exponent;
+	uint64_t mantissa;
+
+	zeros = lrex_float_split(value, &integral, &exponent, &mantissa);
+	integral_nbytes = lrex_count_nbytes(integral);
+
+	if (lre_unlikely(lrex_float_is_big(integral, zeros, negative))) {
+		*tag = negative ? LRE_TAG_NUMBER_NEGATIVE_BIG : LRE_TAG_NUMBER_POSITIVE_BIG;
+		dst[0] = (uint8_t) ((integral_nbytes + zeros) >> 8);
+		dst[1] = (uint8_t) ((integral_nbytes + zeros) & 0xff);
+		lrex_store_be64(dst + 2, integral << (64 - integral_nbytes * 8));
+		memset(dst + 2 + integral_nbytes, 0, zeros);
+		return 2 + integral_nbytes + zeros;
+	}
+
+	*tag = negative ? lrex_tag_by_nbytes_negative(integral_nbytes) : lrex_tag_by_nbytes_positive(integral_nbytes);
+	lrex_store_be64(dst, integral << (64 - integral_nbytes * 8));
+
+	if (lre_likely(mantissa)) {
+		dst[integral_nbytes + 0] = (uint8_t) ((exponent + LRE_EXPONENT_BIAS) >> 8);
+		dst[integral_nbytes + 1] = (uint8_t) ((exponent + LRE_EXPONENT_BIAS) & 0xff);
+		lrex_store_be64(dst + integral_nbytes + 2, mantissa << 8);
+		return integral_nbytes + 2 + lrex_mantissa_nbytes(mantissa, compact);
+	}
+
+	return integral_nbytes;
+}
+
+
+/**
+ * @brief Check that double value can be packed, values beyond 64-bit range are packed as BIG
+ * @return LRE_ERROR_NOTHING if success, LRE_ERROR_NAN otherwise
+ */
+lre_decl
+lre_error_t lrex_check_float(double value) {
+	if (lre_unlikely(lre_isnan(value))) {
+		return LRE_ERROR_NAN;
+	}
+
+	return LRE_ERROR_NOTHING;
+}
+
+
+/**
+ * @brief Returns exact size of packed string
+ */
+lre_decl
+size_t lrex_packed_size_str(size_t len) {
+	/* tag(1) + string(len*2) + encoding(1) + separator(1) */
+	return 1 + len * 2 + 1 + 1;
+}
+
+
+/**
+ * @brief Returns exact size of packed integer
+ */
+lre_decl
+size_t lrex_packed_size_int(int64_t value) {
+	uint64_t sign = 0 - (uint64_t) (value < 0);
+
+	/* tag(1) + value(nbytes*2) + separator(1) */
+	return 1 + lrex_count_nbytes(((uint64_t) value ^ sign) - sign) * 2 + 1;
+}
+
+
+/**
+ * @brief Returns exact size of packed double value (checked by lrex_check_float)
+ * @param compact Non-zero for compact floats (see lre_pack_float_compact())
+ */
+lre_decl
+size_t lrex_packed_size_float(double value, int compact) {
+	uint64_t integral;
+	int      integral_nbytes;
+	int      zeros;
+
+	int      exponent;
+	uint64_t mantissa;
+
+	if (lre_unlikely(lre_isinf(value))) {
+		/* tag(1) + separator(1) */
+		return 1 + 1;
+	}
+
+	zeros = lrex_float_split(value, &integral, &exponent, &mantissa);
+	integral_nbytes = lrex_count_nbytes(integral);
+
+	if (lre_unlikely(lrex_float_is_big(integral, zeros, value < 0.0))) {
+		/* tag(1) + nbytes(4) + integral(nbytes*2) + separator(1) */
+		return 1 + 4 + (integral_nbytes + zeros) * 2 + 1;
+	}
+
+	if (lre_likely(mantissa)) {
+		/* tag(1) + integral(nbytes*2) + exp(4) + fraction(nbytes*2) + separator(1) */
+		return 1 + integral_nbytes * 2 + 4 + lrex_mantissa_nbytes(mantissa, compact) * 2 + 1;
+	}
+
+	/* tag(1) + integral(nbytes*2) + separator(1) */
+	return 1 + integral_nbytes * 2 + 1;
+}
+
+
+/**
+ * @brief Write string. Destination must have lrex_packed_size_str() of space
+ */
+lre_decl
+void lrex_pack_str(uint8_t **dst, const uint8_t *src, size_t len, lre_enc_t enc) {
+	if (lre_unlikely(!enc)) {
+		enc = LRE_ENC_RAW;
+	}
+
+	lrex_write_char(dst, LRE_TAG_STRING);
+	lrex_write_str (dst, src, len, 0);
+	lrex_write_char(dst, (int) enc);
+	lrex_write_char(dst, LRE_SEP_POSITIVE);
+}
+
+
+/**
+ * @brief Write integer. Destination must have LRE_PACK_SLACK of space
+ */
+lre_decl
+void lrex_pack_int(uint8_t **dst, int64_t value) {
+	/* Branchless: sign is 0 for positive and all ones for negative value */
+	uint64_t sign   = 0 - (uint64_t) (value < 0);
+	uint64_t uvalue = ((uint64_t) value ^ sign) - sign;
+	int      nbytes = lrex_count_nbytes(uvalue);
+
+	/* Tag is POSITIVE_1+(nbytes-1) or POSITIVE_1-nbytes (NEGATIVE_1+1-nbytes) */
+	lrex_write_char   (dst, (int) LRE_TAG_NUMBER_POSITIVE_1 + ((nbytes - 1) ^ (int) sign));
+	lrex_write_uint64n_wide(dst, uvalue ^ sign, nbytes);
+	lrex_write_char   (dst, LRE_SEP_POSITIVE + (int) (sign & (LRE_SEP_NEGATIVE - LRE_SEP_POSITIVE)));
+}
+
+
+/**
+ * @brief Write double value checked by lrex_check_float().
+ * Destination must have lrex_packed_size_float() of space
+ * @param compact Non-zero for compact floats (see lre_pack_float_compact())
+ */
+lre_decl
+void lrex_pack_float(uint8_t **dst, double value, int compact) {
+	int negative = 0;
+
+	if (lre_unlikely(lre_isinf(value))) {
+		if (value < 0) {
+			lrex_write_char(dst, LRE_TAG_NUMBER_NEGATIVE_INF);
+			lrex_write_char(dst, LRE_SEP_NEGATIVE);
+		}
+		else {
+			lrex_write_char(dst, LRE_TAG_NUMBER_POSITIVE_INF);
+			lrex_write_char(dst, LRE_SEP_POSITIVE);
+		}
+
+		return;
+	}
+
+	if (value < 0.0) {
+		negative = 1;
+	}
+
+	{
+		uint64_t integral;
+		uint8_t  integral_nbytes;
+		int      zeros;
+
+		int      exponent;
+		uint64_t mantissa;
+		uint8_t  mantissa_nbytes = 7;
+
+		zeros = lrex_float_split(value, &integral, &exponent, &mantissa);
+		integral_nbytes = lrex_count_nbytes(integral);
+
+		/* Out of 64-bit range: the same as lre_pack_bigint() does */
+		if (lre_unlikely(lrex_float_is_big(integral, zeros, negative))) {
+			uint16_t nbytes = (uint16_t) (integral_nbytes + zeros);
+
+			if (negative) {
+				lrex_write_char   (dst, LRE_TAG_NUMBER_NEGATIVE_BIG);
+				lrex_write_uint16 (dst, ~nbytes);
+				lrex_write_uint64n(dst, ~integral, integral_nbytes);
+				memset(*dst, 'a' + 0xf, zeros * 2);
+			}
+			else {
+				lrex_write_char   (dst, LRE_TAG_NUMBER_POSITIVE_BIG);
+				lrex_write_uint16 (dst, nbytes);
+				lrex_write_uint64n(dst, integral, integral_nbytes);
+				memset(*dst, 'a', zeros * 2);
+			}
+
+			*dst += zeros * 2;
+			lrex_write_char(dst, negative ? LRE_SEP_NEGATIVE : LRE_SEP_POSITIVE);
+			return;
+		}
+
+		if (lre_likely(mantissa)) {
+			/* Dropped bytes are zero */
+			mantissa_nbytes = lrex_mantissa_nbytes(mantissa, compact);
+			mantissa >>= (7 - mantissa_nbytes) * 8;
+		}
+
+		if (negative) {
+			lrex_write_char   (dst, (int) lrex_tag_by_nbytes_negative(integral_nbytes));
+			lrex_write_uint64n(dst, ~integral, integral_nbytes);
+
+			if (lre_likely(mantissa)) {
+				lrex_write_uint16 (dst, ~(exponent + LRE_EXPONENT_BIAS));
+				lrex_write_uint64n(dst, ~mantissa, mantissa_nbytes);
+			}
+
+			lrex_write_char(dst, LRE_SEP_NEGATIVE);
+		}
+		else {
+			lrex_write_char   (dst, (int) lrex_tag_by_nbytes_positive(integral_nbytes));
+			lrex_write_uint64n(dst, integral, integral_nbytes);
+
+			if (lre_likely(mantissa)) {
+				lrex_write_uint16 (dst, exponent + LRE_EXPONENT_BIAS);
+				lrex_write_uint64n(dst, mantissa, mantissa_nbytes);
+			}
+
+			lrex_write_char(dst, LRE_SEP_POSITIVE);
+		}
+	}
+}
+
+
+/**
+ * @brief Write string into buffer
+ * @param buf Pointer to lre_buffer_t
+ * @param src Pointer to string
+ * @param len Length of string
+ * @param enc String encofing: LRE_ENC_RAW (also 0), LRE_ENC_UTF8
+ * @param error Pointer to lre_error_t or 0
+ * @return LRE_OK if success, LRE_FAIL otherwise
+ */
+lre_decl
+int lre_pack_str(lre_buffer_t *buf, const uint8_t *src, size_t len, lre_enc_t enc, lre_error_t *error) {
+	if (lre_likely(lre_buffer_require(buf, lrex_packed_size_str(len), error) == LRE_OK)) {
+		uint8_t *dst = lre_buffer_end(buf);
+
+		lrex_pack_str(&dst, src, len, enc);
+		lre_buffer_set_size_distance(buf, dst);
+		return LRE_OK;
+	}
+	
+	return LRE_FAIL;
+}
+
+
+/**
+ * @brief Write 64-bit signed integer value into buffer
+ * @param buf Pointer to lre_buffer_t
+ * @param value Integer value
+ * @param error Pointer to lre_error_t or 0
+ * @return LRE_OK if success, LRE_FAIL otherwise
+ */
+lre_decl
+int lre_pack_int(lre_buffer_t *buf, int64_t value, lre_error_t *error) {
+	/* tag(1) + value(16) + separator(1) */
+	if (lre_likely(lre_buffer_require(buf, (1+16+1), error) == LRE_OK)) {
+		uint8_t *dst = lre_buffer_end(buf);
+
+		lrex_pack_int(&dst, value);
+		lre_buffer_set_size_distance(buf, dst);
+		return LRE_OK;
+	}
+	
+	return LRE_FAIL;
+}
+
+
+/**
+ * @brief Write double value into buffer. Integral values are packed as integers,
+ * so |value| >= 2^63 is packed as BIG and loaded by handler_bigint. Default handler_bigint
+ * passes it to handler_float, lre_get_float() converts it back too.
+ * @param buf Pointer to lre_buffer_t
+ * @param value Double value
+ * @param error Pointer to lre_error_t or 0
+ * @return LRE_OK if success, LRE_FAIL otherwise
+ */
+lre_decl
+int lre_pack_float(lre_buffer_t *buf, double value, lre_error_t *error) {
+	lre_error_t check = lrex_check_float(value);
+
+	if (lre_unlikely(check != LRE_ERROR_NOTHING)) {
+		return lre_fail(check, error);
+	}
+
+	/* tag(1) + nbytes(4) + integral(256) + separator(1), also covers exp(4) + fraction(14) */
+	if (lre_likely(lre_buffer_require(buf, (1+4+256+1), error) == LRE_OK)) {
+		uint8_t *dst = lre_buffer_end(buf);
+
+		lrex_pack_float(&dst, value, 0);
+		lre_buffer_set_size_distance(buf, dst);
+		return LRE_OK;
+	}
+
+	return LRE_FAIL;
+}
+
+
+/**
+ * @brief Write double value into buffer without trailing zero bytes of mantissa,
+ * e.g. 10.5 is 'Makdpppba+' instead of 'Makdpppbaaaaaaaaaaaaa+'.
+ * Compact keys are ordered among themselves and loaded as regular ones,
+ * but they are not equal to regular keys of the same value: pack every
+ * key of one keyspace either way.
+ * @param buf Pointer to lre_buffer_t
+ * @param value Double value
+ * @param error Pointer to lre_error_t or 0
+ * @return LRE_OK if success, LRE_FAIL otherwise
+ */
+lre_decl
+int lre_pack_float_compact(lre_buffer_t *buf, double value, lre_error_t *error) {
+	lre_error_t check = lrex_check_float(value);
+
+	if (lre_unlikely(check != LRE_ERROR_NOTHING)) {
+		return lre_fail(check, error);
+	}
+
+	/* The same space as lre_pack_float() */
+	if (lre_likely(lre_buffer_require(buf, (1+4+256+1), error) == LRE_OK)) {
+		uint8_t *dst = lre_buffer_end(buf);
+
+		lrex_pack_float(&dst, value, 1);
+		lre_buffer_set_size_distance(buf, dst);
+		return LRE_OK;
+	}
+
+	return LRE_FAIL;
+}
+
+
+/**
+ * @brief Write big integer into buffer. Values in 64-bit range are packed as lre_pack_int() does,
+ * others as LRE_TAG_NUMBER_POSITIVE_BIG/LRE_TAG_NUMBER_NEGATIVE_BIG.
+ * @param buf Pointer to lre_buffer_t
+ * @param magnitude Big-endian absolute value. Leading zeros are ignored
+ * @param n Number of bytes of magnitude
+ * @param negative Nonzero for negative value
+ * @param error Pointer to lre_error_t or 0
+ * @return LRE_OK if success, LRE_FAIL otherwise
+ */
+lre_decl
+int lre_pack_bigint(lre_buffer_t *buf, const uint8_t *magnitude, size_t n, int negative, lre_error_t *error) {
+	while (n && !magnitude[0]) {
+		magnitude++;
+		n--;
+	}
+
+	if (n <= 8) {
+		uint64_t value = 0;
+		size_t   i;
+
+		for (i = 0; i < n; i++) {
+			value = (value << 8) | magnitude[i];
+		}
+
+		/* Negative range is one more: -9223372036854775808 */
+		if (value <= UINT64_C(9223372036854775807) + (negative != 0 && value)) {
+			return lre_pack_int(buf, negative ? lrex_negate_positive(value) : (int64_t) value, error);
+		}
+	}
+
+	if (lre_unlikely(n > 65535)) {
+		return lre_fail(LRE_ERROR_RANGE, error);
+	}
+
+	/* tag(1) + nbytes(4) + value(n*2) + separator(1) */
+	if (lre_likely(lre_buffer_require(buf, (1+4+(n*2)+1), error) == LRE_OK)) {
+		uint8_t *dst  = lre_buffer_end(buf);
+		uint8_t  mask = negative ? 0xff : 0;
+
+		if (negative) {
+			lrex_write_char(&dst, LRE_TAG_NUMBER_NEGATIVE_BIG);
+		}
+		else {
+			lrex_write_char(&dst, LRE_TAG_NUMBER_POSITIVE_BIG);
+		}
+
+		lrex_write_uint16(&dst, (uint16_t) n ^ (mask * 0x0101));
+		lrex_write_str   (&dst, magnitude, n, mask);
+		lrex_write_char  (&dst, negative ? LRE_SEP_NEGATIVE : LRE_SEP_POSITIVE);
+
+		lre_buffer_set_size_distance(buf, dst);
+		return LRE_OK;
+	}
+
+	return LRE_FAIL;
+}
+
+
+#if defined(LRE_INT128)
+/**
+ * @brief Write magnitude of BIG number (9-16 bytes) as two words
+ * @param sign 0 for positive, all ones for negative value
+ */
+lre_decl
+void lrex_write_uint128_big(uint8_t **dst, lre_uint128_t magnitude, uint64_t sign) {
+	uint64_t hi = (uint64_t) (magnitude >> 64);
+	uint64_t lo = (uint64_t) magnitude;
+	int      nbytes = 8 + (hi ? lrex_count_nbytes(hi) : 0);
+
+	lrex_write_char   (dst, sign ? LRE_TAG_NUMBER_NEGATIVE_BIG : LRE_TAG_NUMBER_POSITIVE_BIG);
+	lrex_write_uint16 (dst, (uint16_t) (nbytes ^ sign));
+	lrex_write_uint64n(dst, hi ^ sign, nbytes - 8);
+	lrex_write_uint64n(dst, lo ^ sign, 8);
+	lrex_write_char   (dst, sign ? LRE_SEP_NEGATIVE : LRE_SEP_POSITIVE);
+}
+
+
+/**
+ * @brief Write 128-bit signed integer value into buffer. Encoding is the same as
+ * lre_pack_int() in 64-bit range and lre_pack_bigint() otherwise.
+ * @param buf Pointer to lre_buffer_t
+ * @param value Integer value
+ * @param error Pointer to lre_error_t or 0
+ * @return LRE_OK if success, LRE_FAIL otherwise
+ */
+lre_decl
+int lre_pack_int128(lre_buffer_t *buf, lre_int128_t value, lre_error_t *error) {
+	if (value >= INT64_MIN && value <= INT64_MAX) {
+		return lre_pack_int(buf, (int64_t) value, error);
+	}
+
+	/* tag(1) + nbytes(4) + value(32) + separator(1) */
+	if (lre_likely(lre_buffer_require(buf, (1+4+32+1), error) == LRE_OK)) {
+		uint8_t      *dst  = lre_buffer_end(buf);
+		uint64_t      sign = 0 - (uint64_t) (value < 0);
+		lre_uint128_t magnitude = (value < 0) ? 0 - (lre_uint128_t) value : (lre_uint128_t) value;
+
+		lrex_write_uint128_big(&dst, magnitude, sign);
+		lre_buffer_set_size_distance(buf, dst);
+		return LRE_OK;
+	}
+
+	return LRE_FAIL;
+}
+
+
+/**
+ * @brief Write 128-bit unsigned integer value into buffer. Encoding is the same as
+ * lre_pack_int() in 64-bit range and lre_pack_bigint() otherwise.
+ * @param buf Pointer to lre_buffer_t
+ * @param value Integer value
+ * @param error Pointer to lre_error_t or 0
+ * @return LRE_OK if success, LRE_FAIL otherwise
+ */
+lre_decl
+int lre_pack_uint128(lre_buffer_t *buf, lre_uint128_t value, lre_error_t *error) {
+	if (value <= INT64_MAX) {
+		return lre_pack_int(buf, (int64_t) value, error);
+	}
+
+	/* tag(1) + nbytes(4) + value(32) + separator(1) */
+	if (lre_likely(lre_buffer_require(buf, (1+4+32+1), error) == LRE_OK)) {
+		uint8_t *dst = lre_buffer_end(buf);
+
+		lrex_write_uint128_big(&dst, value, 0);
+		lre_buffer_set_size_distance(buf, dst);
+		return LRE_OK;
+	}
+
+	return LRE_FAIL;
+}
+#endif
+
+
+/*
+ * DECIMAL PACKING.
+ * Decimals share the representation of floats: integral part and binary fraction.
+ * Fractions that are exact in binary are packed as lre_pack_float() does, others
+ * take 8 bytes: 61 bits aligned as float mantissa, rounded to odd. That is enough
+ * to restore up to 18 fraction digits and to round correctly to double.
+ */
+
+/* Max size of integral part of decimal with positive exponent (bytes) */
+#define LRE_DECIMAL_INTEGRAL_MAX 256
+
+/* Max number of fraction digits of decimal restored by handler_decimal */
+#define LRE_DECIMAL_DIGITS_MAX 18
+
+/* Max number of fraction digits of packed decimal, keeps fraction exponent in 16 bits */
+#define LRE_DECIMAL_SCALE_MAX 4900
+
+/* Words of 5^LRE_DECIMAL_SCALE_MAX (log2(5) < 7/3) with room for alignment */
+#define LRE_DECIMAL_SCALE_WORDS ((LRE_DECIMAL_SCALE_MAX * 7 / 3 + 64) / 32 + 4)
+
+
+typedef struct {
+	uint64_t coefficient; /* Absolute value of coefficient */
+	int32_t  exponent;    /* Power of 10 */
+	uint8_t  negative;    /* Non-zero for negative values */
+} lre_decimal_t;
+
+
+/**
+ * @brief Power of 10
+ * @param n Exponent, from 0 to 19
+ */
+lre_decl
+uint64_t lrex_pow10(int n) {
+	static const uint64_t table[20] = {
+		UINT64_C(1),
+		UINT64_C(10),
+		UINT64_C(100),
+		UINT64_C(1000),
+		UINT64_C(10000),
+		UINT64_C(100000),
+		UINT64_C(1000000),
+		UINT64_C(10000000),
+		UINT64_C(100000000),
+		UINT64_C(1000000000),
+		UINT64_C(10000000000),
+		UINT64_C(100000000000),
+		UINT64_C(1000000000000),
+		UINT64_C(10000000000000),
+		UINT64_C(100000000000000),
+		UINT64_C(1000000000000000),
+		UINT64_C(10000000000000000),
+		UINT64_C(100000000000000000),
+		UINT64_C(1000000000000000000),
+		UINT64_C(10000000000000000000)
+	};
+
+	return table[n];
+}
+
+
+/**
+ * @brief Full 64x64 multiplication
+ * @param hi High word of product
+ * @return Low word of product
+ */
+lre_decl
+uint64_t lrex_umul64(uint64_t a, uint64_t b, uint64_t *hi) {
+#if defined(LRE_INT128)
+	lre_uint128_t product = (lre_uint128_t) a * b;
+
+	*hi = (uint64_t) (product >> 64);
+	return (uint64_t) product;
+#else
+	uint64_t a_lo = a & 0xffffffff;
+	uint64_t a_hi = a >> 32;
+	uint64_t b_lo = b & 0xffffffff;
+	uint64_t b_hi = b >> 32;
+
+	uint64_t ll  = a_lo * b_lo;
+	uint64_t lh  = a_lo * b_hi;
+	uint64_t hl  = a_hi * b_lo;
+	uint64_t mid = (ll >> 32) + (lh & 0xffffffff) + (hl & 0xffffffff);
+
+	*hi = a_hi * b_hi + (lh >> 32) + (hl >> 32) + (mid >> 32);
+	return (mid << 32) | (ll & 0xffffffff);
+#endif
+}
+
+
+/**
+ * @brief Shift big number left in place. Little-endian words, x must have room
+ * for n + bits/32 + 1 words
+ * @return New number of words
+ */
+lre_decl
+size_t lrex_big_shl(uint32_t *x, size_t n, size_t bits) {
+	size_t   words = bits / 32;
+	unsigned rem   = (unsigned) (bits % 32);
+	size_t   m     = n + words + 1;
+	size_t   i;
+
+	for (i = m; i-- > 0;) {
+		uint64_t hi = (i >= words && i - words < n) ? x[i - words] : 0;
+		uint64_t lo = (i >= words + 1 && i - words - 1 < n) ? x[i - words - 1] : 0;
+
+		x[i] = (uint32_t) ((hi << rem) | (rem ? lo >> (32 - rem) : 0));
+	}
+
+	while (m > 1 && !x[m - 1]) {
+		m--;
+	}
+
+	return m;
+}
+
+
+/**
+ * @brief Compare big numbers
+ * @return Negative, zero or positive as for memcmp()
+ */
+lre_decl
+int lrex_big_cmp(const uint32_t *a, size_t an, const uint32_t *b, size_t bn) {
+	size_t i;
+
+	if (an != bn) {
+		return (an < bn) ? -1 : 1;
+	}
+
+	for (i = an; i-- > 0;) {
+		if (a[i] != b[i]) {
+			return (a[i] < b[i]) ? -1 : 1;
+		}
+	}
+
+	return 0;
+}
+
+
+/**
+ * @brief Subtract b from a in place, a must not be less than b
+ * @return New number of words of a
+ */
+lre_decl
+size_t lrex_big_sub(uint32_t *a, size_t an, const uint32_t *b, size_t bn) {
+	uint64_t borrow = 0;
+	size_t   i;
+
+	for (i = 0; i < an; i++) {
+		uint64_t diff = (uint64_t) a[i] - (i < bn ? b[i] : 0) - borrow;
+
+		a[i]   = (uint32_t) diff;
+		borrow = (diff >> 32) & 1;
+	}
+
+	while (an > 1 && !a[an - 1]) {
+		an--;
+	}
+
+	return an;
+}
+
+
+/**
+ * @brief Number of bits of big number
+ */
+lre_decl
+size_t lrex_big_nbits(const uint32_t *x, size_t n) {
+	return (n - 1) * 32 + (x[n - 1] ? lrex_log2i(x[n - 1]) + 1 : 0);
+}
+
+
+/**
+ * @brief Fraction coefficient / 10^scale for scale that does not fit 64 bits:
+ * 61 bits aligned as float mantissa, rounded to odd
+ * @param coefficient Coefficient, must not be 0
+ * @param scale Number of fraction digits, up to LRE_DECIMAL_SCALE_MAX
+ * @param fraction_exponent Unbiased exponent of fraction (output)
+ * @param mantissa Mantissa (output)
+ */
+lre_decl
+void lrex_decimal_fraction_wide(uint64_t coefficient, int scale, int *fraction_exponent, uint64_t *mantissa) {
+	uint32_t s[LRE_DECIMAL_SCALE_WORDS];
+	uint32_t r[LRE_DECIMAL_SCALE_WORDS];
+	size_t   sn = 1;
+	size_t   rn = 2;
+	size_t   sbits;
+	size_t   rbits;
+	int      k;
+	int      i;
+
+	/* coefficient / 10^scale = (coefficient / 5^scale) * 2^-scale */
+	s[0] = 1;
+
+	for (k = scale; k > 0;) {
+		int      m     = (k < 13) ? k : 13;
+		uint64_t five  = lrex_pow10(m) >> m;
+		uint64_t carry = 0;
+		size_t   j;
+
+		for (j = 0; j < sn; j++) {
+			carry += s[j] * five;
+			s[j]   = (uint32_t) carry;
+			carry >>= 32;
+		}
+
+		if (carry) {
+			s[sn++] = (uint32_t) carry;
+		}
+
+		k -= m;
+	}
+
+	r[0] = (uint32_t) coefficient;
+	r[1] = (uint32_t) (coefficient >> 32);
+	rn   = r[1] ? 2 : 1;
+
+	/* r / s = coefficient / 5^scale * 2^(exponent of r - exponent of s), aligned to [1/2, 1) */
+	sbits = lrex_big_nbits(s, sn);
+	rbits = lrex_big_nbits(r, rn);
+	*fraction_exponent = -scale;
+
+	if (sbits >= rbits) {
+		rn = lrex_big_shl(r, rn, sbits - rbits);
+		*fraction_exponent -= (int) (sbits - rbits);
+	}
+	else {
+		sn = lrex_big_shl(s, sn, rbits - sbits);
+		*fraction_exponent += (int) (rbits - sbits);
+	}
+
+	if (lrex_big_cmp(r, rn, s, sn) >= 0) {
+		sn = lrex_big_shl(s, sn, 1);
+		*fraction_exponent += 1;
+	}
+
+	/* Long division by doubling, as for 64-bit scale */
+	*mantissa = 0;
+
+	for (i = 0; i < 61; i++) {
+		uint64_t bit;
+
+		rn  = lrex_big_shl(r, rn, 1);
+		bit = lrex_big_cmp(r, rn, s, sn) >= 0;
+
+		if (bit) {
+			rn = lrex_big_sub(r, rn, s, sn);
+		}
+
+		*mantissa = (*mantissa << 1) | bit;
+	}
+
+	/* Round to odd */
+	*mantissa |= (rn > 1 || r[0]);
+}
+
+
+/**
+ * @brief Write decimal without fraction digits: coefficient * 10^exponent
+ */
+lre_decl
+int lrex_pack_decimal_integral(lre_buffer_t *buf, uint64_t coefficient, int32_t exponent, int negative, lre_error_t *error) {
+	uint8_t magnitude[LRE_DECIMAL_INTEGRAL_MAX];
+	size_t  start = LRE_DECIMAL_INTEGRAL_MAX - 8;
+	size_t  i;
+
+	if (!coefficient) {
+		exponent = 0;
+	}
+
+	lrex_store_be64(magnitude + start, coefficient);
+
+	/* Multiply by chunks of 10^16, byte * 10^16 + carry fits 64 bits */
+	while (exponent > 0) {
+		int      n     = (exponent < 16) ? exponent : 16;
+		uint64_t scale = lrex_pow10(n);
+		uint64_t carry = 0;
+
+		for (i = LRE_DECIMAL_INTEGRAL_MAX; i-- > start;) {
+			carry += magnitude[i] * scale;
+			magnitude[i] = (uint8_t) (carry & 0xff);
+			carry >>= 8;
+		}
+
+		while (carry) {
+			if (lre_unlikely(start == 0)) {
+				return lre_fail(LRE_ERROR_RANGE, error);
+			}
+
+			magnitude[--start] = (uint8_t) (carry & 0xff);
+			carry >>= 8;
+		}
+
+		exponent -= n;
+	}
+
+	return lre_pack_bigint(buf, magnitude + start, LRE_DECIMAL_INTEGRAL_MAX - start, negative, error);
+}
+
+
+/**
+ * @brief Write decimal value into buffer. Values equal to integers or floats
+ * are packed the same way as lre_pack_int(), lre_pack_bigint() or lre_pack_float() do.
+ * @param buf Pointer to lre_buffer_t
+ * @param dec Pointer to lre_decimal_t. At most LRE_DECIMAL_SCALE_MAX fraction digits
+ * (after trailing zeros of coefficient are dropped) are supported
+ * @param error Pointer to lre_error_t or 0
+ * @return LRE_OK if success, LRE_FAIL otherwise
+ */
+lre_decl
+int lre_pack_decimal(lre_buffer_t *buf, const lre_decimal_t *dec, lre_error_t *error) {
+	uint64_t coefficient = dec->coefficient;
+	int32_t  exponent    = dec->exponent;
+	int      negative    = dec->negative && coefficient;
+
+	uint64_t scale;
+	uint64_t integral;
+	uint64_t rest;
+
+	int      fraction_exponent;
+	uint64_t mantissa;
+	int      mantissa_nbytes;
+
+	while (coefficient && exponent < 0 && coefficient % 10 == 0) {
+		coefficient /= 10;
+		exponent++;
+	}
+
+	if (exponent >= 0 || !coefficient) {
+		return lrex_pack_decimal_integral(buf, coefficient, exponent, negative, error);
+	}
+
+	if (lre_unlikely(exponent < -LRE_DECIMAL_SCALE_MAX)) {
+		return lre_fail(LRE_ERROR_RANGE, error);
+	}
+
+	/* Wider scale has no integral part: coefficient < 2^64 < 10^20 */
+	if (exponent >= -19) {
+		scale    = lrex_pow10(-exponent);
+		integral = coefficient / scale;
+		rest     = coefficient % scale;
+	}
+	else {
+		scale    = 0;
+		integral = 0;
+		rest     = coefficient;
+	}
+
+	{
+		/* rest / (2^n * 5^n) is exact in binary if rest is divisible by 5^n */
+		uint64_t odd = rest;
+		int      n   = 0;
+
+		while (n < -exponent && odd % 5 == 0) {
+			odd /= 5;
+			n++;
+		}
+
+		if (n == -exponent) {
+			int nbits = lrex_log2i(odd) + 1;
+
+			fraction_exponent = nbits - n;
+			mantissa          = odd << (53 - nbits);
+			mantissa_nbytes   = lrex_mantissa_nbytes(mantissa, 0);
+			mantissa        >>= (7 - mantissa_nbytes) * 8;
+		}
+		else if (!scale) {
+			lrex_decimal_fraction_wide(rest, -exponent, &fraction_exponent, &mantissa);
+			mantissa_nbytes = 8;
+		}
+		else {
+			int i;
+
+			/* Long division by doubling: 2*rest >= scale without overflow */
+			fraction_exponent = 0;
+
+			while (rest < scale - rest) {
+				rest += rest;
+				fraction_exponent--;
+			}
+
+			mantissa        = 0;
+			mantissa_nbytes = 8;
+
+			for (i = 0; i < 61; i++) {
+				uint64_t bit = rest >= scale - rest;
+
+				rest = bit ? rest - (scale - rest) : rest + rest;
+				mantissa = (mantissa << 1) | bit;
+			}
+
+			/* Round to odd: order is kept, later rounding to double is correct */
+			mantissa |= (rest != 0);
+		}
+	}
+
+	/* tag(1) + nbytes(4) + integral(16) + exp(4) + fraction(16) + separator(1) */
+	if (lre_likely(lre_buffer_require(buf, (1+4+16+4+16+1), error) == LRE_OK)) {
+		uint8_t *dst    = lre_buffer_end(buf);
+		uint64_t sign   = 0 - (uint64_t) negative;
+		int      nbytes = lrex_count_nbytes(integral);
+
+		if (lre_unlikely(lrex_float_is_big(integral, 0, negative))) {
+			lrex_write_char  (&dst, negative ? LRE_TAG_NUMBER_NEGATIVE_BIG : LRE_TAG_NUMBER_POSITIVE_BIG);
+			lrex_write_uint16(&dst, (uint16_t) (nbytes ^ sign));
+		}
+		else if (negative) {
+			lrex_write_char(&dst, (int) lrex_tag_by_nbytes_negative(nbytes));
+		}
+		else {
+			lrex_write_char(&dst, (int) lrex_tag_by_nbytes_positive(nbytes));
+		}
+
+		lrex_write_uint64n(&dst, integral ^ sign, nbytes);
+		lrex_write_uint16 (&dst, (uint16_t) ((fraction_exponent + LRE_EXPONENT_BIAS) ^ sign));
+		lrex_write_uint64n(&dst, mantissa ^ sign, mantissa_nbytes);
+		lrex_write_char   (&dst, negative ? LRE_SEP_NEGATIVE : LRE_SEP_POSITIVE);
+
+		lre_buffer_set_size_distance(buf, dst);
+		return LRE_OK;
+	}
+
+	return LRE_FAIL;
+}
+
+
+/**
+ * @brief Parse decimal string: [+-]digits[.digits][(e|E)[+-]digits]
+ * @param src Pointer to string
+ * @param len Length of string
+ * @param dec Pointer to lre_decimal_t
+ * @return LRE_ERROR_NOTHING if success, LRE_ERROR_CHAR or LRE_ERROR_RANGE otherwise
+ */
+lre_decl
+lre_error_t lre_decimal_parse(const uint8_t *src, size_t len, lre_decimal_t *dec) {
+	const uint8_t *end      = src + len;
+	uint64_t       coefficient = 0;
+	int64_t        exponent = 0;
+	int64_t        zeros    = 0;
+	int            ndigits  = 0;
+	int            point    = 0;
+
+	dec->negative = 0;
+
+	if (src < end && (*src == '-' || *src == '+')) {
+		dec->negative = *src++ == '-';
+	}
+
+	for (; src < end; src++) {
+		int digit = *src - '0';
+
+		if (*src == '.' && !point) {
+			point = 1;
+			continue;
+		}
+
+		if (digit < 0 || digit > 9) {
+			break;
+		}
+
+		ndigits++;
+		exponent -= point;
+
+		/* Zeros are deferred: trailing ones only change exponent */
+		if (!digit) {
+			zeros++;
+			continue;
+		}
+
+		for (; zeros; zeros--) {
+			if (lre_unlikely(coefficient > UINT64_MAX / 10)) {
+				return LRE_ERROR_RANGE;
+			}
+
+			coefficient *= 10;
+		}
+
+		if (lre_unlikely(coefficient > (UINT64_MAX - digit) / 10)) {
+			return LRE_ERROR_RANGE;
+		}
+
+		coefficient = coefficient * 10 + digit;
+	}
+
+	if (lre_unlikely(!ndigits)) {
+		return LRE_ERROR_CHAR;
+	}
+
+	if (src < end && (*src == 'e' || *src == 'E')) {
+		int64_t value    = 0;
+		int     negative = 0;
+
+		src++;
+
+		if (src < end && (*src == '-' || *src == '+')) {
+			negative = *src++ == '-';
+		}
+
+		if (lre_unlikely(src >= end)) {
+			return LRE_ERROR_CHAR;
+		}
+
+		for (; src < end && *src >= '0' && *src <= '9'; src++) {
+			value = value * 10 + (*src - '0');
+
+			if (lre_unlikely(value > INT32_MAX)) {
+				return LRE_ERROR_RANGE;
+			}
+		}
+
+		exponent += negative ? -value : value;
+	}
+
+	if (lre_unlikely(src != end)) {
+		return LRE_ERROR_CHAR;
+	}
+
+	exponent += zeros;
+
+	if (lre_unlikely(exponent > INT32_MAX || exponent < INT32_MIN)) {
+		return LRE_ERROR_RANGE;
+	}
+
+	dec->coefficient = coefficient;
+	dec->exponent    = (int32_t) exponent;
+	return LRE_ERROR_NOTHING;
+}
+
+
+/**
+ * @brief Write decimal string (see lre_decimal_parse()) or [+-]inf[inity] into buffer
+ * @param buf Pointer to lre_buffer_t
+ * @param src Pointer to string
+ * @param len Length of string
+ * @param error Pointer to lre_error_t or 0
+ * @return LRE_OK if success, LRE_FAIL otherwise
+ */
+lre_decl
+int lre_pack_decimal_str(lre_buffer_t *buf, const uint8_t *src, size_t len, lre_error_t *error) {
+	lre_decimal_t dec;
+	lre_error_t   check;
+	size_t        sign = (len && (*src == '-' || *src == '+'));
+
+	/* Infinity and NaN are spelled as by Python, C or Java, case does not matter */
+	if (lre_unlikely(len - sign >= 3 && (src[sign] | 0x20) >= 'i')) {
+		static const char *const specials[] = {"inf", "infinity", "nan", "snan"};
+		size_t i, j;
+
+		for (i = 0; i < 4; i++) {
+			if (strlen(specials[i]) != len - sign) {
+				continue;
+			}
+
+			for (j = 0; j < len - sign && (src[sign + j] | 0x20) == specials[i][j]; j++);
+
+			if (j == len - sign) {
+				if (i >= 2) {
+					return lre_fail(LRE_ERROR_NAN, error);
+				}
+
+				return lre_pack_float(buf, (*src == '-') ? -HUGE_VAL : HUGE_VAL, error);
+			}
+		}
+	}
+
+	check = lre_decimal_parse(src, len, &dec);
+
+	if (lre_unlikely(check != LRE_ERROR_NOTHING)) {
+		return lre_fail(check, error);
+	}
+
+	return lre_pack_decimal(buf, &dec, error);
+}
+
+
+/* Types of lre_value_t and lre_field_t */
+typedef enum {
+	LRE_TYPE_INT      = 1,
+	LRE_TYPE_FLOAT    = 2,
+	LRE_TYPE_STR      = 3,
+	LRE_TYPE_BIGINT   = 4, /* lre_field_t only */
+	LRE_TYPE_BIGFLOAT = 5  /* lre_field_t only */
+} lre_type_t;
+
+
+/* Field descriptor of lre_pack_row() */
+typedef struct {
+	lre_type_t type;
+
+	union {
+		int64_t i;
+		double  f;
+
+		struct {
+			const uint8_t *src;
+			size_t         len;
+			lre_enc_t      enc;
+		} s;
+	} as;
+} lre_value_t;
+
+
+/* */
+lre_decl
+lre_value_t lre_value_int(int64_t value) {
+	lre_value_t field;
+
+	field.type = LRE_TYPE_INT;
+	field.as.i = value;
+
+	return field;
+}
+
+
+/* */
+lre_decl
+lre_value_t lre_value_float(double value) {
+	lre_value_t field;
+
+	field.type = LRE_TYPE_FLOAT;
+	field.as.f = value;
+
+	return field;
+}
+
+
+/* */
+lre_decl
+lre_value_t lre_value_str(const uint8_t *src, size_t len, lre_enc_t enc) {
+	lre_value_t field;
+
+	field.type     = LRE_TYPE_STR;
+	field.as.s.src = src;
+	field.as.s.len = len;
+	field.as.s.enc = enc;
+
+	return field;
+}
+
+
+/**
+ * @brief Returns exact size of packed fields, 0 if some field is invalid
+ * @param fields Array of fields
+ * @param n Number of fields
+ * @param error Pointer to lre_error_t or 0
+ */
+lre_decl
+size_t lrex_packed_size_row(const lre_value_t *fields, size_t n, lre_error_t *error) {
+	size_t size = 0;
+	size_t i;
+
+	for (i = 0; i < n; i++) {
+		const lre_value_t *field = &fields[i];
+
+		switch (field->type) {
+			case LRE_TYPE_INT:
+				size += lrex_packed_size_int(field->as.i);
+				break;
+
+			case LRE_TYPE_FLOAT: {
+				lre_error_t check = lrex_check_float(field->as.f);
+
+				if (lre_unlikely(check != LRE_ERROR_NOTHING)) {
+					lre_fail(check, error);
+					return 0;
+				}
+
+				size += lrex_packed_size_float(field->as.f, 0);
+				break;
+			}
+
+			case LRE_TYPE_STR:
+				size += lrex_packed_size_str(field->as.s.len);
+				break;
+
+			default:
+				lre_fail(LRE_ERROR_TYPE, error);
+				return 0;
+		}
+	}
+
+	return size;
+}
+
+
+/**
+ * @brief Write all fields without checks. Destination must have
+ * lrex_packed_size_row() + LRE_PACK_SLACK of space
+ * @param dst Pointer to pointer to destination. Shifted by packed size
+ * @param fields Array of fields checked by lrex_packed_size_row()
+ * @param n Number of fields
+ */
+lre_decl
+void lrex_pack_row(uint8_t **dst, const lre_value_t *fields, size_t n) {
+	size_t i;
+
+	for (i = 0; i < n; i++) {
+		const lre_value_t *field = &fields[i];
+
+		switch (field->type) {
+			case LRE_TYPE_INT:
+				lrex_pack_int(dst, field->as.i);
+				break;
+
+			case LRE_TYPE_FLOAT:
+				lrex_pack_float(dst, field->as.f, 0);
+				break;
+
+			default:
+				lrex_pack_str(dst, field->as.s.src, field->as.s.len, field->as.s.enc);
+				break;
+		}
+	}
+}
+
+
+/**
+ * @brief Write all fields into buffer with a single allocation.
+ * Nothing is written if some field is invalid.
+ * @param buf Pointer to lre_buffer_t
+ * @param fields Array of fields
+ * @param n Number of fields
+ * @param error Pointer to lre_error_t or 0
+ * @return LRE_OK if success, LRE_FAIL otherwise
+ */
+lre_decl
+int lre_pack_row(lre_buffer_t *buf, const lre_value_t *fields, size_t n, lre_error_t *error) {
+	lre_error_t check = LRE_ERROR_NOTHING;
+	size_t      size  = lrex_packed_size_row(fields, n, &check);
+
+	if (lre_unlikely(check != LRE_ERROR_NOTHING)) {
+		return lre_fail(check, error);
+	}
+
+	if (lre_likely(lre_buffer_require(buf, size + LRE_PACK_SLACK, error) == LRE_OK)) {
+		uint8_t *dst = lre_buffer_end(buf);
+
+		lrex_pack_row(&dst, fields, n);
+		lre_buffer_set_size_distance(buf, dst);
+		return LRE_OK;
+	}
+
+	return LRE_FAIL;
+}
+
+/**
+ * @brief Returns exact size of packed string
+ * @param len Length of string
+ */
+lre_decl
+size_t lre_packed_size_str(size_t len) {
+	return lrex_packed_size_str(len);
+}
+
+
+/**
+ * @brief Returns exact size of packed 64-bit signed integer
+ * @param value Integer value
+ */
+lre_decl
+size_t lre_packed_size_int(int64_t value) {
+	return lrex_packed_size_int(value);
+}
+
+
+/**
+ * @brief Returns exact size of packed double value
+ * @param value Double value
+ * @return Size if success, 0 if value cannot be packed
+ */
+lre_decl
+size_t lre_packed_size_float(double value) {
+	if (lre_unlikely(lrex_check_float(value) != LRE_ERROR_NOTHING)) {
+		return 0;
+	}
+
+	return lrex_packed_size_float(value, 0);
+}
+
+
+/**
+ * @brief Returns exact size of packed fields
+ * @param fields Array of fields
+ * @param n Number of fields
+ * @param error Pointer to lre_error_t or 0
+ * @return Size if success, 0 if some field is invalid
+ */
+lre_decl
+size_t lre_packed_size_row(const lre_value_t *fields, size_t n, lre_error_t *error) {
+	return lrex_packed_size_row(fields, n, error);
+}
+
+
+/**
+ * @brief Write integer. Never writes past lrex_packed_size_int()
+ */
+lre_decl
+void lrex_pack_int_exact(uint8_t **dst, int64_t value) {
+	uint64_t sign   = 0 - (uint64_t) (value < 0);
+	uint64_t uvalue = ((uint64_t) value ^ sign) - sign;
+	int      nbytes = lrex_count_nbytes(uvalue);
+
+	lrex_write_char   (dst, (int) LRE_TAG_NUMBER_POSITIVE_1 + ((nbytes - 1) ^ (int) sign));
+	lrex_write_uint64n(dst, uvalue ^ sign, nbytes);
+	lrex_write_char   (dst, LRE_SEP_POSITIVE + (int) (sign & (LRE_SEP_NEGATIVE - LRE_SEP_POSITIVE)));
+}
+
+
+/**
+ * @brief Write string into caller memory. No allocation and no null character.
+ * @param dst Destination
+ * @param cap Capacity of destination (see lre_packed_size_str)
+ * @param src Pointer to string
+ * @param len Length of string
+ * @param enc String encofing: LRE_ENC_RAW (also 0), LRE_ENC_UTF8
+ * @param error Pointer to lre_error_t or 0
+ * @return Number of written bytes if success, 0 otherwise
+ */
+lre_decl
+size_t lre_pack_str_into(uint8_t *dst, size_t cap, const uint8_t *src, size_t len, lre_enc_t enc, lre_error_t *error) {
+	size_t   size = lrex_packed_size_str(len);
+	uint8_t *end  = dst;
+
+	if (lre_unlikely(size > cap)) {
+		lre_fail(LRE_ERROR_ALLOCATION_SMALL, error);
+		return 0;
+	}
+
+	lrex_pack_str(&end, src, len, enc);
+	return size;
+}
+
+
+/**
+ * @brief Write 64-bit signed integer value into caller memory. No allocation and no null character.
+ * @param dst Destination
+ * @param cap Capacity of destination (see lre_packed_size_int)
+ * @param value Integer value
+ * @param error Pointer to lre_error_t or 0
+ * @return Number of written bytes if success, 0 otherwise
+ */
+lre_decl
+size_t lre_pack_int_into(uint8_t *dst, size_t cap, int64_t value, lre_error_t *error) {
+	size_t   size = lrex_packed_size_int(value);
+	uint8_t *end  = dst;
+
+	if (lre_unlikely(size > cap)) {
+		lre_fail(LRE_ERROR_ALLOCATION_SMALL, error);
+		return 0;
+	}
+
+	/* tag(1) + value(16) + separator(1) */
+	if (lre_likely(cap >= 1+16+1)) {
+		lrex_pack_int(&end, value);
+	}
+	else {
+		lrex_pack_int_exact(&end, value);
+	}
+
+	return size;
+}
+
+
+/**
+ * @brief Write double value into caller memory. No allocation and no null character.
+ * @param dst Destination
+ * @param cap Capacity of destination (see lre_packed_size_float)
+ * @param value Double value
+ * @param error Pointer to lre_error_t or 0
+ * @return Number of written bytes if success, 0 otherwise
+ */
+lre_decl
+size_t lre_pack_float_into(uint8_t *dst, size_t cap, double value, lre_error_t *error) {
+	lre_error_t check = lrex_check_float(value);
+	uint8_t    *end   = dst;
+	size_t      size;
+
+	if (lre_unlikely(check != LRE_ERROR_NOTHING)) {
+		lre_fail(check, error);
+		return 0;
+	}
+
+	size = lrex_packed_size_float(value, 0);
+
+	if (lre_unlikely(size > cap)) {
+		lre_fail(LRE_ERROR_ALLOCATION_SMALL, error);
+		return 0;
+	}
+
+	lrex_pack_float(&end, value, 0);
+	return size;
+}
+
+
+/**
+ * @brief Write all fields into caller memory. No allocation and no null character.
+ * Nothing is written if some field is invalid or capacity is too small.
+ * @param dst Destination
+ * @param cap Capacity of destination (see lre_packed_size_row)
+ * @param fields Array of fields
+ * @param n Number of fields
+ * @param error Pointer to lre_error_t or 0
+ * @return Number of written bytes if success, 0 otherwise
+ */
+lre_decl
+size_t lre_pack_row_into(uint8_t *dst, size_t cap, const lre_value_t *fields, size_t n, lre_error_t *error) {
+	lre_error_t check = LRE_ERROR_NOTHING;
+	size_t      size  = lrex_packed_size_row(fields, n, &check);
+	uint8_t    *end   = dst;
+	size_t      i;
+
+	if (lre_unlikely(check != LRE_ERROR_NOTHING)) {
+		lre_fail(check, error);
+		return 0;
+	}
+
+	if (lre_unlikely(size > cap)) {
+		lre_fail(LRE_ERROR_ALLOCATION_SMALL, error);
+		return 0;
+	}
+
+	if (lre_likely(cap - size >= LRE_PACK_SLACK)) {
+		lrex_pack_row(&end, fields, n);
+		return size;
+	}
+
+	/* Exactly sized destination: integers are written without slack */
+	for (i = 0; i < n; i++) {
+		if (fields[i].type == LRE_TYPE_INT) {
+			lrex_pack_int_exact(&end, fields[i].as.i);
+		}
+		else {
+			lrex_pack_row(&end, &fields[i], 1);
+		}
+	}
+
+	return size;
+}
+
+/* Column of lre_pack_columns() */
+typedef struct {
+	lre_type_t     type;
+	const void    *data; /* int64_t[], double[] or const uint8_t *[] (LRE_TYPE_STR) */
+	const size_t  *lens; /* Lengths of strings (LRE_TYPE_STR only) */
+	lre_enc_t      enc;  /* Encoding of strings (LRE_TYPE_STR only) */
+} lre_column_t;
+
+
+/* Key pair with the same layout as MDB_val */
+typedef struct {
+	size_t  size;
+	void   *data;
+} lre_val_t;
+
+
+/**
+ * @brief Pack rows of columns (struct of arrays) into buffer with a single allocation.
+ *
+ * Every row becomes one key, keys are contiguous in buffer data: the key of row r
+ * is data[offsets[r]] .. data[offsets[r+1]]. Values are written one column at a time.
+ * Nothing is written if some value is invalid.
+ *
+ * @param buf Pointer to lre_buffer_t. Keys are appended to buffer
+ * @param columns Array of columns
+ * @param ncolumns Number of columns
+ * @param nrows Number of rows
+ * @param offsets Array of nrows+1 offsets (output)
+ * @param error Pointer to lre_error_t or 0
+ * @return LRE_OK if success, LRE_FAIL otherwise
+ */
+lre_decl
+int lre_pack_columns(lre_buffer_t *buf, const lre_column_t *columns, size_t ncolumns, size_t nrows, size_t *offsets, lre_error_t *error) {
+	size_t c;
+	size_t r;
+
+	memset(offsets, 0, (nrows + 1) * sizeof(size_t));
+	offsets[0] = buf->size;
+
+	/* Sizes of rows are accumulated in offsets[r+1] */
+	for (c = 0; c < ncolumns; c++) {
+		const lre_column_t *column = &columns[c];
+
+		if (lre_unlikely(!column->data || (column->type == LRE_TYPE_STR && !column->lens))) {
+			return lre_fail(LRE_ERROR_NULLPTR, error);
+		}
+
+		switch (column->type) {
+			case LRE_TYPE_INT: {
+				const int64_t *values = (const int64_t *) column->data;
+
+				for (r = 0; r < nrows; r++) {
+					offsets[r + 1] += lrex_packed_size_int(values[r]);
+				}
+
+				break;
+			}
+
+			case LRE_TYPE_FLOAT: {
+				const double *values = (const double *) column->data;
+
+				for (r = 0; r < nrows; r++) {
+					lre_error_t check = lrex_check_float(values[r]);
+
+					if (lre_unlikely(check != LRE_ERROR_NOTHING)) {
+						return lre_fail(check, error);
+					}
+
+					offsets[r + 1] += lrex_packed_size_float(values[r], 0);
+				}
+
+				break;
+			}
+
+			case LRE_TYPE_STR:
+				for (r = 0; r < nrows; r++) {
+					offsets[r + 1] += lrex_packed_size_str(column->lens[r]);
+				}
+
+				break;
+
+			default:
+				return lre_fail(LRE_ERROR_TYPE, error);
+		}
+	}
+
+	for (r = 0; r < nrows; r++) {
+		offsets[r + 1] += offsets[r];
+	}
+
+	if (lre_unlikely(lre_buffer_require(buf, offsets[nrows] - buf->size, error) != LRE_OK)) {
+		return LRE_FAIL;
+	}
+
+	/* offsets[r] is a cursor of row r. Writers must not write past the value */
+	for (c = 0; c < ncolumns; c++) {
+		const lre_column_t *column = &columns[c];
+
+		switch (column->type) {
+			case LRE_TYPE_INT: {
+				const int64_t *values = (const int64_t *) column->data;
+
+				for (r = 0; r < nrows; r++) {
+					uint8_t *dst = buf->data + offsets[r];
+
+					lrex_pack_int_exact(&dst, values[r]);
+					offsets[r] = dst - buf->data;
+				}
+
+				break;
+			}
+
+			case LRE_TYPE_FLOAT: {
+				const double *values = (const double *) column->data;
+
+				for (r = 0; r < nrows; r++) {
+					uint8_t *dst = buf->data + offsets[r];
+
+					lrex_pack_float(&dst, values[r], 0);
+					offsets[r] = dst - buf->data;
+				}
+
+				break;
+			}
+
+			default: {
+				const uint8_t *const *values = (const uint8_t *const *) column->data;
+
+				for (r = 0; r < nrows; r++) {
+					uint8_t *dst = buf->data + offsets[r];
+
+					lrex_pack_str(&dst, values[r], column->lens[r], column->enc);
+					offsets[r] = dst - buf->data;
+				}
+
+				break;
+			}
+		}
+	}
+
+	/* Cursors point to ends of rows, shift them to starts */
+	for (r = nrows; r > 0; r--) {
+		offsets[r] = offsets[r - 1];
+	}
+
+	offsets[0] = buf->size;
+	lre_buffer_set_size_distance(buf, buf->data + offsets[nrows]);
+
+	return LRE_OK;
+}
+
+
+/**
+ * @brief Fill key pairs from offsets of lre_pack_columns().
+ * Pairs are invalidated after calls that reallocate buffer.
+ * @param buf Pointer to lre_buffer_t
+ * @param offsets Array of nrows+1 offsets
+ * @param nrows Number of rows
+ * @param vals Array of nrows pairs (output)
+ */
+lre_decl
+void lre_columns_vals(const lre_buffer_t *buf, const size_t *offsets, size_t nrows, lre_val_t *vals) {
+	size_t r;
+
+	for (r = 0; r < nrows; r++) {
+		vals[r].size = offsets[r + 1] - offsets[r];
+		vals[r].data = buf->data + offsets[r];
+	}
+}
+
+/*
+ * DENSE PACKING.
+ * Tags are lowercase, payload is encoded with 6 bits per character.
+ * Dense keys are ordered among themselves, but not against regular keys.
+ */
+
+/**
+ * @brief Write string into buffer (dense encoding)
+ * @param buf Pointer to lre_buffer_t
+ * @param src Pointer to string
+ * @param len Length of string
+ * @param enc String encofing: LRE_ENC_RAW (also 0), LRE_ENC_UTF8
+ * @param error Pointer to lre_error_t or 0
+ * @return LRE_OK if success, LRE_FAIL otherwise
+ */
+lre_decl
+int lre_pack_dense_str(lre_buffer_t *buf, const uint8_t *src, size_t len, lre_enc_t enc, lre_error_t *error) {
+	switch ((int) enc) {
+		case LRE_ENC_NONE:
+		case LRE_ENC_RAW:        enc = LRE_ENC_DENSE_RAW;  break;
+		case LRE_ENC_UTF8:       enc = LRE_ENC_DENSE_UTF8; break;
+		case LRE_ENC_DENSE_RAW:  break;
+		case LRE_ENC_DENSE_UTF8: break;
+		default: return lre_fail(LRE_ERROR_ENC, error);
+	}
+
+	/* tag(1) + string(nchars) + encoding(1) + separator(1) */
+	if (lre_likely(lre_buffer_require(buf, (1+lrex_dense_nchars(len)+1+1), error) == LRE_OK)) {
+		uint8_t *dst = lre_buffer_end(buf);
+
+		lrex_write_char (&dst, (int) lrex_tag_dense(LRE_TAG_STRING));
+		lrex_write_dense(&dst, src, len, 0);
+		lrex_write_char (&dst, (int) enc);
+		lrex_write_char (&dst, LRE_SEP_POSITIVE);
+		lre_buffer_set_size_distance(buf, dst);
+		return LRE_OK;
+	}
+
+	return LRE_FAIL;
+}
+
+
+/**
+ * @brief Write 64-bit signed integer value into buffer (dense encoding)
+ * @param buf Pointer to lre_buffer_t
+ * @param value Integer value
+ * @param error Pointer to lre_error_t or 0
+ * @return LRE_OK if success, LRE_FAIL otherwise
+ */
+lre_decl
+int lre_pack_dense_int(lre_buffer_t *buf, int64_t value, lre_error_t *error) {
+	/* tag(1) + value(11) + separator(1) */
+	if (lre_likely(lre_buffer_require(buf, (1+11+1), error) == LRE_OK)) {
+		uint8_t *dst = lre_buffer_end(buf);
+		uint8_t  tmp[8];
+
+		uint64_t  sign   = 0 - (uint64_t) (value < 0);
+		uint64_t  uvalue = ((uint64_t) value ^ sign) - sign;
+		int       nbytes = lrex_count_nbytes(uvalue);
+		lre_tag_t tag    = (lre_tag_t) ((int) LRE_TAG_NUMBER_POSITIVE_1 + ((nbytes - 1) ^ (int) sign));
+
+		/* Magnitude is complemented by lrex_write_dense() */
+		lrex_store_be64(tmp, uvalue);
+
+		lrex_write_char (&dst, (int) lrex_tag_dense(tag));
+		lrex_write_dense(&dst, tmp + 8 - nbytes, nbytes, (uint8_t) sign);
+		lrex_write_char (&dst, LRE_SEP_POSITIVE + (int) (sign & (LRE_SEP_NEGATIVE - LRE_SEP_POSITIVE)));
+
+		lre_buffer_set_size_distance(buf, dst);
+		return LRE_OK;
+	}
+
+	return LRE_FAIL;
+}
+
+
+/**
+ * @brief Write double value into buffer (dense encoding)
+ * @param compact Non-zero for compact floats (see lre_pack_float_compact())
+ */
+lre_decl
+int lrex_pack_dense_float(lre_buffer_t *buf, double value, int compact, lre_error_t *error) {
+	lre_error_t check = lrex_check_float(value);
+
+	if (lre_unlikely(check != LRE_ERROR_NOTHING)) {
+		return lre_fail(check, error);
+	}
+
+	/* tag(1) + payload as characters + separator(1) */
+	if (lre_likely(lre_buffer_require(buf, 1 + lrex_dense_nchars(LRE_FLOAT_PAYLOAD_MAX) + 1, error) == LRE_OK)) {
+		uint8_t *dst = lre_buffer_end(buf);
+
+		if (lre_unlikely(lre_isinf(value))) {
+			if (value < 0) {
+				lrex_write_char(&dst, (int) lrex_tag_dense(LRE_TAG_NUMBER_NEGATIVE_INF));
+				lrex_write_char(&dst, LRE_SEP_NEGATIVE);
+			}
+			else {
+				lrex_write_char(&dst, (int) lrex_tag_dense(LRE_TAG_NUMBER_POSITIVE_INF));
+				lrex_write_char(&dst, LRE_SEP_POSITIVE);
+			}
+
+			lre_buffer_set_size_distance(buf, dst);
+			return LRE_OK;
+		}
+
+		{
+			uint8_t   mask = 0xff * (value < 0.0);
+			uint8_t   payload[LRE_FLOAT_PAYLOAD_MAX];
+			lre_tag_t tag;
+			size_t    nbytes = lrex_float_payload(payload, value, &tag, compact);
+
+			lrex_write_char (&dst, (int) lrex_tag_dense(tag));
+			lrex_write_dense(&dst, payload, nbytes, mask);
+			lrex_write_char (&dst, mask ? LRE_SEP_NEGATIVE : LRE_SEP_POSITIVE);
+		}
+
+		lre_buffer_set_size_distance(buf, dst);
+		return LRE_OK;
+	}
+
+	return LRE_FAIL;
+}
+
+
+/**
+ * @brief Write double value into buffer (dense encoding)
+ * @param buf Pointer to lre_buffer_t
+ * @param value Double value
+ * @param error Pointer to lre_error_t or 0
+ * @return LRE_OK if success, LRE_FAIL otherwise
+ */
+lre_decl
+int lre_pack_dense_float(lre_buffer_t *buf, double value, lre_error_t *error) {
+	return lrex_pack_dense_float(buf, value, 0, error);
+}
+
+
+/**
+ * @brief Write double value into buffer without trailing zero bytes of mantissa
+ * (dense encoding, see lre_pack_float_compact())
+ * @param buf Pointer to lre_buffer_t
+ * @param value Double value
+ * @param error Pointer to lre_error_t or 0
+ * @return LRE_OK if success, LRE_FAIL otherwise
+ */
+lre_decl
+int lre_pack_dense_float_compact(lre_buffer_t *buf, double value, lre_error_t *error) {
+	return lrex_pack_dense_float(buf, value, 1, error);
+}
+
+
+/*
+ * BINARY PACKING.
+ * Tags are the same as regular ones, the format is not ASCII-safe.
+ * Binary keys are ordered among themselves and loaded by lre_tokenize_bin().
+ * Float mantissa is always 7 bytes here, there are no compact floats.
+ */
+
+/**
+ * @brief Write string into buffer (binary format)
+ * @param buf Pointer to lre_buffer_t
+ * @param src Pointer to string
+ * @param len Length of string
+ * @param enc String encofing: LRE_ENC_RAW (also 0), LRE_ENC_UTF8
+ * @param error Pointer to lre_error_t or 0
+ * @return LRE_OK if success, LRE_FAIL otherwise
+ */
+lre_decl
+int lre_pack_bin_str(lre_buffer_t *buf, const uint8_t *src, size_t len, lre_enc_t enc, lre_error_t *error) {
+	switch ((int) enc) {
+		case LRE_ENC_NONE:
+		case LRE_ENC_RAW:      enc = LRE_ENC_BIN_RAW;  break;
+		case LRE_ENC_UTF8:     enc = LRE_ENC_BIN_UTF8; break;
+		case LRE_ENC_BIN_RAW:  break;
+		case LRE_ENC_BIN_UTF8: break;
+		default: return lre_fail(LRE_ERROR_ENC, error);
+	}
+
+	/* tag(1) + escaped string(len*2) + terminator(1) + encoding(1) */
+	if (lre_likely(lre_buffer_require(buf, (1+(len*2)+1+1), error) == LRE_OK)) {
+		uint8_t *dst = lre_buffer_end(buf);
+
+		lrex_write_char   (&dst, LRE_TAG_STRING);
+		lrex_write_bin_str(&dst, src, len);
+		lrex_write_char   (&dst, LRE_BIN_TERM_POSITIVE);
+		lrex_write_char   (&dst, (int) enc);
+		lre_buffer_set_size_distance(buf, dst);
+		return LRE_OK;
+	}
+
+	return LRE_FAIL;
+}
+
+
+/**
+ * @brief Write 64-bit signed integer value into buffer (binary format)
+ * @param buf Pointer to lre_buffer_t
+ * @param value Integer value
+ * @param error Pointer to lre_error_t or 0
+ * @return LRE_OK if success, LRE_FAIL otherwise
+ */
+lre_decl
+int lre_pack_bin_int(lre_buffer_t *buf, int64_t value, lre_error_t *error) {
+	/* tag(1) + value(8) + terminator(1) */
+	if (lre_likely(lre_buffer_require(buf, (1+8+1), error) == LRE_OK)) {
+		uint8_t *dst = lre_buffer_end(buf);
+
+		uint64_t sign   = 0 - (uint64_t) (value < 0);
+		uint64_t uvalue = ((uint64_t) value ^ sign) - sign;
+		int      nbytes = lrex_count_nbytes(uvalue);
+
+		lrex_write_char(&dst, (int) LRE_TAG_NUMBER_POSITIVE_1 + ((nbytes - 1) ^ (int) sign));
+
+		/* Always 8 bytes are stored, only nbytes of them are used */
+		lrex_store_be64(dst, (uvalue ^ sign) << (64 - nbytes * 8));
+		dst += nbytes;
+
+		lrex_write_char(&dst, (uint8_t) sign);
+		lre_buffer_set_size_distance(buf, dst);
+		return LRE_OK;
+	}
+
+	return LRE_FAIL;
+}
+
+
+/**
+ * @brief Write double value into buffer (binary format)
+ * @param buf Pointer to lre_buffer_t
+ * @param value Double value
+ * @param error Pointer to lre_error_t or 0
+ * @return LRE_OK if success, LRE_FAIL otherwise
+ */
+lre_decl
+int lre_pack_bin_float(lre_buffer_t *buf, double value, lre_error_t *error) {
+	lre_error_t check = lrex_check_float(value);
+
+	if (lre_unlikely(check != LRE_ERROR_NOTHING)) {
+		return lre_fail(check, error);
+	}
+
+	/* tag(1) + payload + terminator(1) */
+	if (lre_likely(lre_buffer_require(buf, (1+LRE_FLOAT_PAYLOAD_MAX+1), error) == LRE_OK)) {
+		uint8_t *dst = lre_buffer_end(buf);
+
+		if (lre_unlikely(lre_isinf(value))) {
+			if (value < 0) {
+				lrex_write_char(&dst, LRE_TAG_NUMBER_NEGATIVE_INF);
+				lrex_write_char(&dst, LRE_BIN_TERM_NEGATIVE);
+			}
+			else {
+				lrex_write_char(&dst, LRE_TAG_NUMBER_POSITIVE_INF);
+				lrex_write_char(&dst, LRE_BIN_TERM_POSITIVE);
+			}
+
+			lre_buffer_set_size_distance(buf, dst);
+			return LRE_OK;
+		}
+
+		{
+			uint8_t   mask = 0xff * (value < 0.0);
+			uint8_t  *start = dst++;
+			lre_tag_t tag;
+			size_t    nbytes = lrex_float_payload(dst, value, &tag, 0);
+			size_t    i;
+
+			/* Payload is written in place, tag is known after it */
+			*start = (uint8_t) tag;
+
+			for (i = 0; mask && i < nbytes; i++) {
+				dst[i] ^= mask;
+			}
+
+			dst += nbytes;
+			lrex_write_char(&dst, mask);
+		}
+
+		lre_buffer_set_size_distance(buf, dst);
+		return LRE_OK;
+	}
+
+	return LRE_FAIL;
+}
+
+
+/*
+ * */
+typedef struct {
+	lre_tag_t      tag;               /* Numeric tag */
+	uint8_t        negative_mask;     /* 0xff for negative numbers, 0 otherwise */
+
+	const uint8_t *integral_data;     /* Pointer to integral */
+	uint16_t       integral_nbytes;   /* Number of bytes of integral part */
+
+	const uint8_t *fraction_data;     /* Pointer to fraction part (mantissa) */
+	uint16_t       fraction_nbytes;   /* Number of bytes of fraction part */
+	int32_t        fraction_exponent; /* Unbiased exponent of fraction part */
+} lre_metanumber_t;
+
+
+/**
+ * @brief Decode integral part of number (big-endian absolute value) straight from key.
+ * Typically used by handler_bigint.
+ * @param num Pointer to lre_metanumber_t
+ * @param dst Destination with at least num->integral_nbytes of space
+ * @param error Pointer to lre_error_t or 0
+ * @return LRE_OK if success, LRE_FAIL otherwise
+ */
+lre_decl
+int lre_metanumber_read_integral(const lre_metanumber_t *num, uint8_t *dst, lre_error_t *error) {
+	const uint8_t *src = num->integral_data;
+
+	if (lre_unlikely(lrex_read_str_checked(&src, dst, num->integral_nbytes, num->negative_mask) != LRE_OK)) {
+		return lre_fail(LRE_ERROR_CHAR, error);
+	}
+
+	return LRE_OK;
+}
+
+
+/**
+ * @brief Shift value right rounding to nearest, ties to even
+ * @param value Value
+ * @param shift Number of bits to drop
+ * @param sticky Non-zero if non-zero bits were already lost below value
+ * @return Rounded value
+ */
+lre_decl
+uint64_t lrex_round_shift(uint64_t value, int shift, int sticky) {
+	uint64_t kept;
+	uint64_t rest;
+	uint64_t half;
+
+	if (shift <= 0) {
+		return value;
+	}
+
+	if (shift > 64) {
+		return 0;
+	}
+
+	kept = (shift < 64) ? value >> shift : 0;
+	rest = value - (kept << (shift - 1) << 1);
+	half = UINT64_C(1) << (shift - 1);
+
+	if (rest > half || (rest == half && (sticky || (kept & 1)))) {
+		kept++;
+	}
+
+	return kept;
+}
+
+
+/**
+ * @brief Convert integral part of big number to correctly rounded double.
+ * Fraction part only affects rounding, integral part must have more than 64 bits then.
+ * @param num Pointer to lre_metanumber_t
+ * @param out Pointer to result
+ * @param error Pointer to lre_error_t or 0. LRE_ERROR_RANGE if value is beyond double range
+ * @return LRE_OK if success, LRE_FAIL otherwise
+ */
+lre_decl
+int lrex_metanumber_double(const lre_metanumber_t *num, double *out, lre_error_t *error) {
+	const uint8_t *src    = num->integral_data;
+	size_t         rest   = num->integral_nbytes;
+	uint64_t       hi     = 0;
+	int            sticky = 0;
+	int            top;
+	uint64_t       bits;
+
+	/* Leading zero bytes are not packed, but do not rely on it */
+	while (rest && !hi) {
+		hi = lrex_read_uint64n(&src, 1, num->negative_mask);
+		rest--;
+	}
+
+	if (lre_unlikely(!hi)) {
+		*out = (num->negative_mask && !num->fraction_data) ? -0.0 : 0.0;
+		return num->fraction_data ? lre_fail(LRE_ERROR_RANGE, error) : LRE_OK;
+	}
+
+	/* The first 8 significant bytes, the rest is sticky */
+	while (rest && hi < (UINT64_C(1) << 56)) {
+		hi = (hi << 8) | lrex_read_uint64n(&src, 1, num->negative_mask);
+		rest--;
+	}
+
+	top = lrex_log2i(hi) + (int) rest * 8;
+
+	if (lre_unlikely(num->fraction_data && top < 64)) {
+		return lre_fail(LRE_ERROR_RANGE, error);
+	}
+
+	while (rest) {
+		size_t nbytes = (rest < 8) ? rest : 8;
+
+		sticky |= lrex_read_uint64n(&src, nbytes, num->negative_mask) != 0;
+		rest -= nbytes;
+	}
+
+	if (num->fraction_data) {
+		const uint8_t *fsrc  = num->fraction_data;
+		size_t         frest = num->fraction_nbytes;
+
+		while (frest) {
+			size_t nbytes = (frest < 8) ? frest : 8;
+
+			sticky |= lrex_read_uint64n(&fsrc, nbytes, num->negative_mask) != 0;
+			frest -= nbytes;
+		}
+	}
+
+	if (lre_unlikely(top > 1023)) {
+		return lre_fail(LRE_ERROR_RANGE, error);
+	}
+
+	/* Carry of rounding into bit 53 increments exponent, up to infinity */
+	bits = ((uint64_t) (top + 1022) << 52) + lrex_round_shift(hi << (63 - lrex_log2i(hi)), 11, sticky);
+
+	if (lre_unlikely(bits >= UINT64_C(0x7ff0000000000000))) {
+		return lre_fail(LRE_ERROR_RANGE, error);
+	}
+
+	bits |= (uint64_t) (num->negative_mask & 1) << 63;
+	memcpy(out, &bits, sizeof(*out));
+	return LRE_OK;
+}
+
+
+typedef struct lre_loader_t lre_loader_t;
+
+/* LRE end handlers for unpack.
+ * Normally, it is long-lived objects. */
+typedef struct lre_loader_t {
+	void *app_private;
+	int (*handler_int)     (lre_loader_t *loader, int64_t value);
+	int (*handler_float)   (lre_loader_t *loader, double value);
+	int (*handler_inf)     (lre_loader_t *loader, lre_tag_t tag);
+	int (*handler_str)     (lre_loader_t *loader, lre_slice_t *slice, lre_enc_t enc);
+	int (*handler_bigint)  (lre_loader_t *loader, const lre_metanumber_t *num);
+	int (*handler_bigfloat)(lre_loader_t *loader, const lre_metanumber_t *num);
+	/* BIG integers in 128-bit range if set, handler_bigint otherwise (default).
+	 * Declared without LRE_INT128 too: layout must not depend on compiler settings */
+#if defined(LRE_INT128)
+	int (*handler_int128)  (lre_loader_t *loader, lre_int128_t value);
+#else
+	int (*handler_int128)  (lre_loader_t *loader, const void *unused);
+#endif
+	/* Non-integer numbers representable as lre_decimal_t if set, handler_float otherwise (default) */
+	int (*handler_decimal) (lre_loader_t *loader, const lre_decimal_t *dec);
+	/* Called after each key by lre_tokenize_batch() if set */
+	int (*handler_key_end) (lre_loader_t *loader, size_t index);
+	/* Index of current key in lre_tokenize_batch() */
+	size_t key_index;
+} lre_loader_t;
+
+
+lre_decl
+int lre_loader_default_handler_int(lre_loader_t *loader, int64_t value) {
+	lre_debug("call\n");
+	return LRE_FAIL;
+}
+
+
+lre_decl
+int lre_loader_default_handler_float(lre_loader_t *loader, double value) {
+	lre_debug("call\n");
+	return LRE_FAIL;
+}
+
+
+lre_decl
+int lre_loader_default_handler_str(lre_loader_t *loader, lre_slice_t *slice, lre_enc_t enc) {
+	lre_debug("call\n");
+	return LRE_FAIL;
+}
+
+
+lre_decl
+int lre_loader_default_handler_inf(lre_loader_t *loader, lre_tag_t tag) {
+	double value = lrex_tag_is_negative(tag) ? -INFINITY : INFINITY;
+	lre_debug("call\n");
+
+	if (lre_likely(loader->handler_float)) {
+		return loader->handler_float(loader, value);
+	}
+
+	return LRE_OK;
+}
+
+
+/* Big integers in double range are passed to handler_float, e.g. lre_pack_float(1e20) */
+lre_decl
+int lre_loader_default_handler_bigint(lre_loader_t *loader, const lre_metanumber_t *num) {
+	double value;
+	lre_debug("call\n");
+
+	if (lre_unlikely(lrex_metanumber_double(num, &value, 0) != LRE_OK)) {
+		return LRE_FAIL;
+	}
+
+	return loader->handler_float(loader, value);
+}
+
+
+lre_decl
+int lre_loader_default_handler_bigfloat(lre_loader_t *loader, const lre_metanumber_t *num) {
+	double value;
+	lre_debug("call\n");
+
+	/* Only if fraction does not matter beyond rounding */
+	if (lre_unlikely(lrex_metanumber_double(num, &value, 0) != LRE_OK)) {
+		return LRE_FAIL;
+	}
+
+	return loader->handler_float(loader, value);
+}
+
+
+lre_decl
+void lre_loader_init(lre_loader_t *loader, void *app_private) {
+	loader->app_private      = app_private;
+
+	loader->handler_int      = &lre_loader_default_handler_int;
+	loader->handler_float    = &lre_loader_default_handler_float;
+	loader->handler_str      = &lre_loader_default_handler_str;
+	loader->handler_inf      = &lre_loader_default_handler_inf;
+	loader->handler_bigint   = &lre_loader_default_handler_bigint;
+	loader->handler_bigfloat = &lre_loader_default_handler_bigfloat;
+	loader->handler_int128   = 0;
+	loader->handler_decimal  = 0;
+	loader->handler_key_end  = 0;
+	loader->key_index        = 0;
+}
+
+
+/**
+ * @brief Pop and check encoding of string, check length of its payload
+ * @param tag String tag (regular or dense)
+ * @param slice Payload of string with encoding, encoding is removed
+ * @param encoding Encoding of string
+ * @param error Pointer to lre_error_t or 0
+ * @return LRE_OK if success, LRE_FAIL otherwise
+ */
+lre_decl
+int lrex_read_string_enc(lre_tag_t tag, lre_slice_t *slice, lre_enc_t *encoding, lre_error_t *error) {
+	if (lre_unlikely(lre_slice_len(slice) < 1)) {
+		return lre_fail(LRE_ERROR_LENGTH, error);
+	}
+	
+	/* Last character is a encoding value */
+	*encoding = (lre_enc_t) lre_slice_pop(slice);
+	
+	if (lre_unlikely(lrex_enc_is_dense(*encoding) != lrex_tag_is_dense(tag))) {
+		return lre_fail(LRE_ERROR_ENC, error);
+	}
+
+	switch (*encoding) {
+		case LRE_ENC_UTF8:
+		case LRE_ENC_RAW:
+			if (lre_unlikely(lre_slice_len(slice) % 2)) {
+				return lre_fail(LRE_ERROR_LENGTH, error);
+			}
+			break;
+
+		case LRE_ENC_DENSE_UTF8:
+		case LRE_ENC_DENSE_RAW:
+			if (lre_unlikely(lre_slice_len(slice) % 4 == 1)) {
+				return lre_fail(LRE_ERROR_LENGTH, error);
+			}
+			break;
+
+		default: return lre_fail(LRE_ERROR_ENC, error);
+	}
+
+	return LRE_OK;
+}
+
+
+lre_decl // TODO
+int lre_load_string(lre_loader_t *loader, lre_tag_t tag, lre_slice_t *slice, lre_error_t *error) {
+	lre_enc_t encoding;
+
+	if (lre_unlikely(lrex_read_string_enc(tag, slice, &encoding, error) != LRE_OK)) {
+		return LRE_FAIL;
+	}
+	
+	if (lre_unlikely(loader->handler_str(loader, slice, encoding) != LRE_OK)) {
+		return lre_fail(LRE_ERROR_HANDLER, error);
+	}
+	
+	return LRE_OK;
+}
+
+
+/**
+ * @brief Check range of integer magnitude and call handler_int
+ * @param integral Magnitude of integer
+ * @param negative_mask 0xff for negative numbers, 0 otherwise
+ */
+lre_decl
+int lrex_load_int(lre_loader_t *loader, uint64_t integral, uint8_t negative_mask, lre_error_t *error) {
+	int64_t value;
+
+	if (lre_unlikely(lrex_int_from_magnitude(integral, negative_mask, &value, error) != LRE_OK)) {
+		return LRE_FAIL;
+	}
+
+	if (lre_unlikely(loader->handler_int(loader, value) != LRE_OK)) {
+		return lre_fail(LRE_ERROR_HANDLER, error);
+	}
+
+	return LRE_OK;
+}
+
+
+lre_decl
+int lrex_load_number_integer(lre_loader_t *loader, const lre_metanumber_t *num, lre_error_t *error) {
+	uint64_t integral;
+	const uint8_t *src = num->integral_data;
+
+	if (lre_unlikely(num->integral_nbytes > 8 || lrex_tag_is_number_big(num->tag))) {
+#if defined(LRE_INT128)
+		if (loader->handler_int128 && num->integral_nbytes <= 16) {
+			const uint8_t *isrc = num->integral_data;
+			int nhi = (num->integral_nbytes > 8) ? num->integral_nbytes - 8 : 0;
+
+			lre_uint128_t magnitude = lrex_read_uint64n(&isrc, nhi, num->negative_mask);
+			magnitude = (magnitude << 64) | lrex_read_uint64n(&isrc, num->integral_nbytes - nhi, num->negative_mask);
+
+			/* Negative range is one more */
+			if (magnitude <= ((lre_uint128_t) 1 << 127) - 1 + (num->negative_mask & 1)) {
+				lre_int128_t value = num->negative_mask ? (lre_int128_t) (0 - magnitude) : (lre_int128_t) magnitude;
+
+				if (lre_unlikely(loader->handler_int128(loader, value) != LRE_OK)) {
+					return lre_fail(LRE_ERROR_HANDLER, error);
+				}
+
+				return LRE_OK;
+			}
+		}
+#endif
+
+		if (lre_unlikely(loader->handler_bigint(loader, num) != LRE_OK)) {
+			return lre_fail(LRE_ERROR_HANDLER, error);
+		}
+
+		return LRE_OK;
+	}
+
+	integral = lrex_read_uint64n(&src, num->integral_nbytes, num->negative_mask);
+
+	return lrex_load_int(loader, integral, num->negative_mask, error);
+}
+
+
+/**
+ * @brief Find the shortest decimal for integral.fraction. Fraction is exact if its length
+ * is less than 8 bytes (float), otherwise it is rounded to odd by lre_pack_decimal()
+ * and the decimal is less than ulp away.
+ * @param integral Integral part
+ * @param fraction Fraction as read from key (not normalized)
+ * @param exponent Unbiased exponent of fraction part, must not be positive
+ * @param exact Non-zero if fraction is exact
+ * @param dec Pointer to lre_decimal_t, sign is not set
+ * @return LRE_OK if success, LRE_FAIL if there is no such decimal
+ */
+lre_decl
+int lrex_fraction_decimal(uint64_t integral, uint64_t fraction, int exponent, int exact, lre_decimal_t *dec) {
+	/* Fraction is fraction / 2^width */
+	int width = (fraction ? lrex_log2i(fraction) + 1 : 0) - exponent;
+	int n;
+
+	if (width >= 128) {
+		return LRE_FAIL;
+	}
+
+	for (n = 0; n <= LRE_DECIMAL_DIGITS_MAX; n++) {
+		uint64_t scale = lrex_pow10(n);
+		uint64_t hi;
+		uint64_t lo = lrex_umul64(fraction, scale, &hi);
+		uint64_t quotient;
+		int      below; /* fraction * 10^n is less than ulp above quotient */
+		int      above; /* fraction * 10^n is less than ulp below quotient + 1 */
+
+		if (width > 64) {
+			uint64_t rest_max = (UINT64_C(1) << (width - 64)) - 1;
+			uint64_t rest_hi  = hi & rest_max;
+
+			quotient = hi >> (width - 64);
+			below    = !rest_hi && (exact ? !lo : lo < scale);
+			above    = !exact && rest_hi == rest_max && lo > 0 - scale;
+		}
+		else {
+			uint64_t rest = (width == 64) ? lo : lo & ((UINT64_C(1) << width) - 1);
+
+			quotient = (width == 64) ? hi : (width ? (hi << (64 - width)) | (lo >> width) : lo);
+			below    = exact ? !rest : rest < scale;
+
+			/* 2^width - rest, halves do not overflow */
+			above    = !exact && rest && ((UINT64_C(1) << (width - 1)) - rest) + (UINT64_C(1) << (width - 1)) < scale;
+		}
+
+		if (!below && !above) {
+			continue;
+		}
+
+		quotient += !below;
+		lo = lrex_umul64(integral, scale, &hi);
+
+		if (hi || lo + quotient < lo) {
+			return LRE_FAIL;
+		}
+
+		dec->coefficient = lo + quotient;
+		dec->exponent    = -n;
+		return LRE_OK;
+	}
+
+	return LRE_FAIL;
+}
+
+
+/**
+ * @brief Read integral part and leading 8 bytes of fraction of number with fraction
+ * @param integral Integral part
+ * @param fraction Leading 8 bytes of fraction (not normalized)
+ * @param sticky Non-zero if the rest of fraction is not zero
+ * @return LRE_OK if success, LRE_FAIL if number is out of double range (bigfloat)
+ */
+lre_decl
+int lrex_number_fraction(const lre_metanumber_t *num, uint64_t *integral, uint64_t *fraction, int *sticky) {
+	const uint8_t *isrc = num->integral_data;
+	const uint8_t *fsrc = num->fraction_data;
+	size_t fraction_nbytes  = (num->fraction_nbytes < 8) ? num->fraction_nbytes : 8;
+	size_t tail_nbytes      = num->fraction_nbytes - fraction_nbytes;
+
+	if (lre_unlikely(num->integral_nbytes > 8 || num->fraction_exponent > 0)) {
+		return LRE_FAIL;
+	}
+
+	*integral = lrex_read_uint64n(&isrc, num->integral_nbytes, num->negative_mask);
+	*fraction = lrex_read_uint64n(&fsrc, fraction_nbytes, num->negative_mask);
+	*sticky   = 0;
+
+	/* Tail of long fraction only affects rounding */
+	while (lre_unlikely(tail_nbytes)) {
+		size_t nbytes = (tail_nbytes < 8) ? tail_nbytes : 8;
+
+		*sticky |= lrex_read_uint64n(&fsrc, nbytes, num->negative_mask) != 0;
+		tail_nbytes -= nbytes;
+	}
+
+	/* Leading zero byte would leave too few bits for rounding */
+	if (lre_unlikely(*sticky && !(*fraction >> 56))) {
+		return LRE_FAIL;
+	}
+
+	return LRE_OK;
+}
+
+
+/**
+ * @brief Assemble correctly rounded double from parts read by lrex_number_fraction()
+ * @param exponent Unbiased exponent of fraction part
+ * @param negative_mask 0xff for negative numbers, 0 otherwise
+ * @return Double value
+ */
+lre_decl
+double lrex_number_double(uint64_t integral, uint64_t fraction, int exponent, int sticky, uint8_t negative_mask) {
+	uint64_t bits;
+	double   value;
+
+	/* Fraction is left-aligned: its leading one has weight 2^(exponent-1) */
+	if (lre_likely(fraction)) {
+		fraction <<= 63 - lrex_log2i(fraction);
+	}
+
+	if (integral) {
+		/* 128-bit fixed point integral.fraction normalized to leading one of integral */
+		int      top   = lrex_log2i(integral);
+		int      shift = -exponent;
+		uint64_t lo    = 0;
+		uint64_t hi;
+
+		if (shift < 64) {
+			lo = fraction >> shift;
+			sticky |= (fraction & ((UINT64_C(1) << shift) - 1)) != 0;
+		}
+		else {
+			sticky |= fraction != 0;
+		}
+
+		hi = integral << (63 - top);
+
+		if (top < 63) {
+			hi |= lo >> (top + 1);
+			sticky |= (lo << (63 - top)) != 0;
+		}
+		else {
+			sticky |= lo != 0;
+		}
+
+		/* Carry of rounding into bit 53 increments exponent */
+		bits = ((uint64_t) (top + 1022) << 52) + lrex_round_shift(hi, 11, sticky);
+	}
+	else if (fraction) {
+		int top = exponent - 1;
+
+		if (lre_likely(top >= -1022)) {
+			bits = ((uint64_t) (top + 1022) << 52) + lrex_round_shift(fraction, 11, sticky);
+		}
+		else {
+			/* Subnormal */
+			bits = lrex_round_shift(fraction, -1011 - top, sticky);
+		}
+	}
+	else {
+		bits = 0;
+	}
+
+	bits |= (uint64_t) (negative_mask & 1) << 63;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+
+lre_decl
+int lrex_load_number_float(lre_loader_t *loader, const lre_metanumber_t *num, lre_error_t *error) {
+	uint64_t integral;
+	uint64_t fraction;
+	int      sticky;
+	double   value;
+
+	if (lre_unlikely(lrex_number_fraction(num, &integral, &fraction, &sticky) != LRE_OK)) {
+		if (lre_unlikely(loader->handler_bigfloat(loader, num) != LRE_OK)) {
+			return lre_fail(LRE_ERROR_HANDLER, error);
+		}
+
+		return LRE_OK;
+	}
+
+	if (loader->handler_decimal && num->fraction_nbytes <= 8) {
+		lre_decimal_t dec;
+
+		if (lrex_fraction_decimal(integral, fraction, num->fraction_exponent, num->fraction_nbytes < 8, &dec) == LRE_OK) {
+			dec.negative = num->negative_mask & 1;
+
+			if (lre_unlikely(loader->handler_decimal(loader, &dec) != LRE_OK)) {
+				return lre_fail(LRE_ERROR_HANDLER, error);
+			}
+
+			return LRE_OK;
+		}
+	}
+
+	value = lrex_number_double(integral, fraction, num->fraction_exponent, sticky, num->negative_mask);
+
+	if (lre_unlikely(loader->handler_float(loader, value) != LRE_OK)) {
+		return lre_fail(LRE_ERROR_HANDLER, error);
+	}
+
+	return LRE_OK;
+}
+
+
+/**
+ * @brief Read layout of finite number (without INF tags)
+ * @param tag Numeric tag
+ * @param slice Payload of number
+ * @param num Pointer to lre_metanumber_t, fraction_data is 0 for integers
+ * @param error Pointer to lre_error_t or 0
+ * @return LRE_OK if success, LRE_FAIL otherwise
+ */
+lre_decl
+int lrex_read_metanumber(lre_tag_t tag, lre_slice_t *slice, lre_metanumber_t *num, lre_error_t *error) {
+	num->tag = tag;
+	num->negative_mask = 0xff * lrex_tag_is_negative(tag);
+
+	if (lre_unlikely(lrex_tag_is_number_big(tag))) {
+		if (lre_unlikely(lre_slice_len(slice) < 4)) {
+			return lre_fail(LRE_ERROR_LENGTH, error);
+		}
+
+		num->integral_nbytes = lrex_read_uint16(&slice->src, num->negative_mask);
+	}
+	else if (num->negative_mask) {
+		num->integral_nbytes = lrex_nbytes_by_tag_negative(tag);
+	}
+	else {
+		num->integral_nbytes = lrex_nbytes_by_tag_positive(tag);
+	}
+
+	if (lre_unlikely(num->integral_nbytes * 2 > lre_slice_len(slice))) {
+		return lre_fail(LRE_ERROR_LENGTH, error);
+	}
+
+	num->integral_data = slice->src;
+	slice->src += num->integral_nbytes * 2;
+
+	if (lre_slice_len(slice) < 4) {
+		num->fraction_data     = 0;
+		num->fraction_nbytes   = 0;
+		num->fraction_exponent = 0;
+		return LRE_OK;
+	}
+
+	num->fraction_exponent = lrex_read_uint16(&slice->src, num->negative_mask);
+	num->fraction_exponent -= LRE_EXPONENT_BIAS;
+	num->fraction_data = slice->src;
+	num->fraction_nbytes = lre_slice_len(slice) / 2;
+
+	return LRE_OK;
+}
+
+
+lre_decl // TODO
+int lre_load_number(lre_loader_t *loader, lre_tag_t tag, lre_slice_t *slice, lre_error_t *error) {
+	lre_metanumber_t num;
+
+	if (lre_unlikely(lrex_tag_is_number_inf(tag))) {
+		if (lre_unlikely(loader->handler_inf(loader, tag) != LRE_OK)) {
+			return lre_fail(LRE_ERROR_HANDLER, error);
+		}
+
+		return LRE_OK;
+	}
+
+	if (lre_unlikely(lrex_read_metanumber(tag, slice, &num, error) != LRE_OK)) {
+		return LRE_FAIL;
+	}
+
+	if (!num.fraction_data) {
+		return lrex_load_number_integer(loader, &num, error);
+	}
+
+	return lrex_load_number_float(loader, &num, error);
+}
+
+
+/**
+ * @brief Transcode payload of dense number to regular encoding
+ * @param slice Payload of dense number
+ * @param hex Destination with LRE_TRANSCODE_NUMBER_MAX*2 of space
+ * @param hslice Transcoded payload
+ * @param error Pointer to lre_error_t or 0
+ * @return LRE_OK if success, LRE_FAIL otherwise
+ */
+lre_decl
+int lrex_transcode_dense_number(lre_slice_t *slice, uint8_t *hex, lre_slice_t *hslice, lre_error_t *error) {
+	uint8_t   payload[LRE_TRANSCODE_NUMBER_MAX];
+	uint8_t  *dst    = hex;
+	ptrdiff_t nchars = lre_slice_len(slice);
+	size_t    nbytes = lrex_dense_nbytes(nchars);
+
+	if (lre_unlikely(nchars % 4 == 1 || nbytes > LRE_TRANSCODE_NUMBER_MAX)) {
+		return lre_fail(LRE_ERROR_LENGTH, error);
+	}
+
+	if (lre_unlikely(lrex_read_dense(&slice->src, payload, nchars, 0) != LRE_OK)) {
+		return lre_fail(LRE_ERROR_CHAR, error);
+	}
+
+	/* Complemented bytes of negative numbers are kept as is */
+	lrex_write_str(&dst, payload, nbytes, 0);
+	hslice->src = hex;
+	hslice->end = dst;
+
+	return LRE_OK;
+}
+
+
+/**
+ * @brief Load dense value. Numbers are transcoded to regular encoding.
+ * @param loader Pointer to lre_loader_t
+ * @param tag Dense tag
+ * @param slice Payload of value
+ * @param error Pointer to lre_error_t or 0
+ * @return LRE_OK if success, LRE_FAIL otherwise
+ */
+lre_decl
+int lre_load_dense(lre_loader_t *loader, lre_tag_t tag, lre_slice_t *slice, lre_error_t *error) {
+	lre_tag_t regular = lrex_tag_regular(tag);
+
+	if (lrex_tag_is_string(regular)) {
+		return lre_load_string(loader, tag, slice, error);
+	}
+
+	if (lre_unlikely(!lrex_tag_is_number(regular))) {
+		return lre_fail(LRE_ERROR_TAG, error);
+	}
+
+	if (lre_unlikely(lrex_tag_is_number_inf(regular))) {
+		return lre_load_number(loader, regular, slice, error);
+	}
+
+	{
+		uint8_t     hex[LRE_TRANSCODE_NUMBER_MAX * 2];
+		lre_slice_t hslice;
+
+		if (lre_unlikely(lrex_transcode_dense_number(slice, hex, &hslice, error) != LRE_OK)) {
+			return LRE_FAIL;
+		}
+
+		return lre_load_number(loader, regular, &hslice, error);
+	}
+}
+
+
+/**
+ * @brief Load values from string that created by lre_pack_* family
+ * @param loader Pointer to lre_loader_t
+ * @param src Pointer to string
+ * @param size Size of string
+ * @param error Pointer to lre_error_t or 0
+ * @return LRE_OK if success, LRE_FAIL otherwise
+ */
+lre_decl
+int lre_tokenize(lre_loader_t *loader, const uint8_t *src, size_t size, lre_error_t *error) {
+	const uint8_t *sep = src;
+	const uint8_t *end = src + size;
+	
+	while ((sep = lrex_memsep(src, end - src))) {
+		lre_tag_t   tag   = (lre_tag_t) lrex_read_char(&src);
+		lre_slice_t slice = {src, sep};
+
+		src = sep + 1;
+		
+		if (lre_unlikely(lre_slice_len(&slice) < 0)) {
+			return lre_fail(LRE_ERROR_LENGTH, error);
+		}
+
+		if (lrex_tag_is_dense(tag)) {
+			if (lre_unlikely(lre_load_dense(loader, tag, &slice, error) != LRE_OK)) {
+				return LRE_FAIL;
+			}
+
+			continue;
+		}
+
+		if (lrex_tag_is_string(tag)) {
+			if (lre_unlikely(lre_load_string(loader, tag, &slice, error) != LRE_OK)) {
+				return LRE_FAIL;
+			}
+			
+			continue;
+		}
+		
+		if (lrex_tag_is_number(tag)) {
+			if (lre_unlikely(lre_load_number(loader, tag, &slice, error) != LRE_OK)) {
+				return LRE_FAIL;
+			}
+			
+			continue;
+		}
+		
+		return lre_fail(LRE_ERROR_TAG, error);
+	}
+
+	return LRE_OK;
+}
+
+
+/**
+ * @brief Load binary number. Integers are loaded directly, other numbers
+ * are transcoded to regular encoding.
+ * @param loader Pointer to lre_loader_t
+ * @param tag Numeric tag
+ * @param src Pointer to pointer to payload. Shifted to next value
+ * @param end Pointer to end of data
+ * @param error Pointer to lre_error_t or 0
+ * @return LRE_OK if success, LRE_FAIL otherwise
+ */
+lre_decl
+int lre_load_bin_number(lre_loader_t *loader, lre_tag_t tag, const uint8_t **src, const uint8_t *end, lre_error_t *error) {
+	const uint8_t *start = *src;
+	uint8_t  mask = 0xff * lrex_tag_is_negative(tag);
+	size_t   nbytes;
+	size_t   header = 0;
+
+	if (lre_unlikely(lrex_tag_is_number_inf(tag))) {
+		if (lre_unlikely(end - start < 1 || start[0] != mask)) {
+			return lre_fail(LRE_ERROR_LENGTH, error);
+		}
+
+		*src = start + 1;
+
+		if (lre_unlikely(loader->handler_inf(loader, tag) != LRE_OK)) {
+			return lre_fail(LRE_ERROR_HANDLER, error);
+		}
+
+		return LRE_OK;
+	}
+
+	if (lre_unlikely(lrex_tag_is_number_big(tag))) {
+		if (lre_unlikely(end - start < 2)) {
+			return lre_fail(LRE_ERROR_LENGTH, error);
+		}
+
+		header = 2;
+		nbytes = ((start[0] << 8) | start[1]) ^ (mask * 0x0101);
+	}
+	else if (mask) {
+		nbytes = lrex_nbytes_by_tag_negative(tag);
+	}
+	else {
+		nbytes = lrex_nbytes_by_tag_positive(tag);
+	}
+
+	/* header + integral + terminator or exp(2) */
+	if (lre_unlikely((size_t) (end - start) < header + nbytes + 1)) {
+		return lre_fail(LRE_ERROR_LENGTH, error);
+	}
+
+	/* Integer fast path */
+	if (lre_likely(start[header + nbytes] == mask && !header)) {
+		uint8_t  tmp[8] = {0};
+		uint64_t used   = UINT64_C(0xffffffffffffffff) >> (64 - nbytes * 8);
+
+		memcpy(tmp + 8 - nbytes, start, nbytes);
+		*src = start + nbytes + 1;
+
+		return lrex_load_int(loader, lrex_load_be64(tmp) ^ (used & (0 - (uint64_t) (mask & 1))), mask, error);
+	}
+
+	if (start[header + nbytes] != mask) {
+		/* exp(2) + fraction(7) + terminator */
+		if (lre_unlikely((size_t) (end - start) < header + nbytes + 2 + 7 + 1)) {
+			return lre_fail(LRE_ERROR_LENGTH, error);
+		}
+
+		nbytes += 2 + 7;
+
+		if (lre_unlikely(start[header + nbytes] != mask)) {
+			return lre_fail(LRE_ERROR_LENGTH, error);
+		}
+	}
+
+	nbytes += header;
+	*src = start + nbytes + 1;
+
+	if (lre_unlikely(nbytes > LRE_TRANSCODE_NUMBER_MAX)) {
+		return lre_fail(LRE_ERROR_LENGTH, error);
+	}
+
+	{
+		uint8_t     hex[LRE_TRANSCODE_NUMBER_MAX * 2];
+		uint8_t    *dst   = hex;
+		lre_slice_t slice = {hex, hex};
+
+		lrex_write_str(&dst, start, nbytes, 0);
+		slice.end = dst;
+
+		return lre_load_number(loader, tag, &slice, error);
+	}
+}
+
+
+/**
+ * @brief Load values from binary data that created by lre_pack_bin_* family
+ * @param loader Pointer to lre_loader_t
+ * @param src Pointer to data
+ * @param size Size of data
+ * @param error Pointer to lre_error_t or 0
+ * @return LRE_OK if success, LRE_FAIL otherwise
+ */
+lre_decl
+int lre_tokenize_bin(lre_loader_t *loader, const uint8_t *src, size_t size, lre_error_t *error) {
+	const uint8_t *end = src + size;
+
+	while (src < end) {
+		lre_tag_t tag = (lre_tag_t) lrex_read_char(&src);
+
+		if (lrex_tag_is_string(tag)) {
+			const uint8_t *term = src;
+			lre_slice_t    slice;
+			lre_enc_t      enc;
+
+			/* Find 0x00 that is not followed by escape */
+			while ((term = memchr(term, 0x00, end - term)) && term + 1 < end && term[1] == LRE_BIN_ESCAPE) {
+				term += 2;
+			}
+
+			if (lre_unlikely(!term || term + 1 >= end)) {
+				return lre_fail(LRE_ERROR_LENGTH, error);
+			}
+
+			enc = (lre_enc_t) term[1];
+
+			if (lre_unlikely(!lrex_enc_is_bin(enc))) {
+				return lre_fail(LRE_ERROR_ENC, error);
+			}
+
+			slice.src = src;
+			slice.end = term;
+			src = term + 2;
+
+			if (lre_unlikely(loader->handler_str(loader, &slice, enc) != LRE_OK)) {
+				return lre_fail(LRE_ERROR_HANDLER, error);
+			}
+
+			continue;
+		}
+
+		if (lrex_tag_is_number(tag)) {
+			if (lre_unlikely(lre_load_bin_number(loader, tag, &src, end, error) != LRE_OK)) {
+				return LRE_FAIL;
+			}
+
+			continue;
+		}
+
+		return lre_fail(LRE_ERROR_TAG, error);
+	}
+
+	return LRE_OK;
+}
+
+
+/*
+ * BATCH TOKENIZATION.
+ * Keys are processed back to back by one loader, loader->key_index is set for handlers.
+ */
+
+/* Load keys[first .. first + n), key_index and handler_key_end see global indices */
+lre_decl
+int lrex_tokenize_batch_range(lre_loader_t *loader, const lre_slice_t *keys,
+                              size_t first, size_t n, lre_error_t *error) {
+	size_t i, end = first + n;
+
+	for (i = first; i < end; i++) {
+		/* Next key is usually not far, but not in cache either */
+		if (lre_likely(i + 1 < end)) {
+			lre_prefetch(keys[i + 1].src);
+		}
+
+		loader->key_index = i;
+
+		if (lre_unlikely(lre_tokenize(loader, keys[i].src, lre_slice_len(&keys[i]), error) != LRE_OK)) {
+			return LRE_FAIL;
+		}
+
+		if (loader->handler_key_end) {
+			if (lre_unlikely(loader->handler_key_end(loader, i) != LRE_OK)) {
+				return lre_fail(LRE_ERROR_HANDLER, error);
+			}
+		}
 	}
 
 	return LRE_OK;
@@ -536,578 +5940,834 @@ int lre_buffer_reallocate(lre_buffer_t *buf, size_t capacity, lre_error_t *error
 
 
 /**
- * @brief Create buffer instance with reserved memory. The buffer memory is always terminated with an extra null character.
- * @param reserve Reserved space. Always incremented by 1
+ * @brief Load values from array of keys created by lre_pack_* family
+ * @param loader Pointer to lre_loader_t, handler_key_end is called after each key
+ * @param keys Array of keys
+ * @param n Number of keys
  * @param error Pointer to lre_error_t or 0
- * @return Pointer to lre_buffer_t instance if success, 0 otherwise
+ * @return LRE_OK if success, LRE_FAIL otherwise (loader->key_index is failed key)
  */
 lre_decl
-lre_buffer_t *lre_buffer_create(size_t reserve, lre_error_t *error) {
-	lre_buffer_t *buf = lre_std_calloc(1, sizeof(lre_buffer_t));
+int lre_tokenize_batch(lre_loader_t *loader, const lre_slice_t *keys, size_t n, lre_error_t *error) {
+	return lrex_tokenize_batch_range(loader, keys, 0, n, error);
+}
 
-	if (lre_unlikely(!buf)) {
-		lre_fail(LRE_ERROR_ALLOCATION, error);
-		return 0;
-	}
 
-	reserve++;
+#if defined(LRE_PTHREADS)
 
-	if (lre_unlikely(lre_buffer_reallocate(buf, reserve, error) != LRE_OK)) {
-		return 0;
-	}
+/* Part of batch processed by one worker */
+typedef struct {
+	lre_loader_t      *loader;
+	const lre_slice_t *keys;
+	size_t             first;
+	size_t             n;
+	int                result;
+	lre_error_t        error;
+} lrex_batch_part_t;
 
-	buf->data[0] = '\0';
-	buf->reserved = reserve;
-	buf->capacity = reserve;
 
-	return buf;
+lre_decl
+int lrex_tokenize_batch_part(lrex_batch_part_t *part) {
+	part->error  = LRE_ERROR_NOTHING;
+	part->result = lrex_tokenize_batch_range(part->loader, part->keys, part->first, part->n, &part->error);
+	return part->result;
+}
+
+
+lre_decl
+void *lrex_tokenize_batch_worker(void *arg) {
+	lrex_tokenize_batch_part((lrex_batch_part_t *) arg);
+	return 0;
 }
 
 
+/* Maximal number of workers of lre_tokenize_batch_mt() */
+#if !defined(LRE_BATCH_WORKERS_MAX)
+	#define LRE_BATCH_WORKERS_MAX 64
+#endif
+
+
 /**
- * @brief If available capacity < required, allocate additional memory.
- * @param buf Pointer to lre_buffer_t
- * @param required Required memory
+ * @brief Load values from array of keys in parallel. Batch is split into contiguous
+ * parts, one per worker, the calling thread processes the first one.
+ * Handlers must be safe to call from several threads at once.
+ * @param loaders Array of nworkers loaders, one per worker (e.g. with own app_private)
+ * @param nworkers Number of workers, from 1 to LRE_BATCH_WORKERS_MAX
+ * @param keys Array of keys
+ * @param n Number of keys
  * @param error Pointer to lre_error_t or 0
- * @return LRE_OK if success, LRE_FAIL otherwise
+ * @return LRE_OK if success, LRE_FAIL otherwise (key_index of failed loader is failed key)
  */
 lre_decl
-int lre_buffer_require(lre_buffer_t *buf, size_t required, lre_error_t *error) {
-	size_t capacity = buf->size + required + 1;
+int lre_tokenize_batch_mt(lre_loader_t *loaders, size_t nworkers,
+                          const lre_slice_t *keys, size_t n, lre_error_t *error) {
+	lrex_batch_part_t parts[LRE_BATCH_WORKERS_MAX];
+	pthread_t         threads[LRE_BATCH_WORKERS_MAX];
+	int               started[LRE_BATCH_WORKERS_MAX];
+	size_t            w;
+
+	if (lre_unlikely(nworkers < 1 || nworkers > LRE_BATCH_WORKERS_MAX)) {
+		return lre_fail(LRE_ERROR_RANGE, error);
+	}
 
-	if (lre_unlikely(capacity > buf->capacity)) {
-		return lre_buffer_reallocate(buf, capacity, error);
+	if (nworkers > n) {
+		nworkers = n ? n : 1;
+	}
+
+	for (w = 0; w < nworkers; w++) {
+		parts[w].loader = &loaders[w];
+		parts[w].keys   = keys;
+		parts[w].first  = n / nworkers * w + ((w < n % nworkers) ? w : n % nworkers);
+		parts[w].n      = n / nworkers + (w < n % nworkers);
+		parts[w].result = LRE_OK;
+		parts[w].error  = LRE_ERROR_NOTHING;
+	}
+
+	for (w = 1; w < nworkers; w++) {
+		started[w] = pthread_create(&threads[w], 0, &lrex_tokenize_batch_worker, &parts[w]) == 0;
+	}
+
+	lrex_tokenize_batch_part(&parts[0]);
+
+	for (w = 1; w < nworkers; w++) {
+		if (started[w]) {
+			pthread_join(threads[w], 0);
+		}
+		else {
+			/* Out of threads: do it here */
+			lrex_tokenize_batch_part(&parts[w]);
+		}
+	}
+
+	for (w = 0; w < nworkers; w++) {
+		if (lre_unlikely(parts[w].result != LRE_OK)) {
+			return lre_fail(parts[w].error, error);
+		}
 	}
 
 	return LRE_OK;
 }
 
+#endif
+
+
+/*
+ * PULL READER.
+ * Alternative to lre_tokenize() without handlers: fields are returned one by one.
+ */
+
+/* Field returned by lre_reader_next() */
+typedef struct {
+	lre_type_t type;
+	lre_tag_t  tag; /* Tag as in key, lowercase for dense fields */
+
+	union {
+		int64_t i; /* LRE_TYPE_INT */
+		double  f; /* LRE_TYPE_FLOAT, also +INF and -INF */
+
+		struct {
+			lre_slice_t slice; /* Encoded payload, see lre_slice_read_str() */
+			lre_enc_t   enc;
+		} s;       /* LRE_TYPE_STR */
+
+		lre_metanumber_t num; /* LRE_TYPE_BIGINT and LRE_TYPE_BIGFLOAT, num.tag is regular */
+	} as;
+} lre_field_t;
+
+
+typedef struct {
+	const uint8_t *src; /* Next field */
+	const uint8_t *end;
+
+	/* Dense numbers transcoded to regular encoding, valid until next field */
+	uint8_t hex[LRE_TRANSCODE_NUMBER_MAX * 2];
+} lre_reader_t;
+
 
 /**
- * @brief Returns pointer to next to last character.
- *
- * This call is mostly used for write to end of buffer.
- * Returned pointer is invalidated after calls lre_buffer_reset(), lre_buffer_require(), lre_buffer_close().
- *
- * @param buf Pointer to lre_buffer_t
+ * @brief Start reading of key created by lre_pack_* or lre_pack_dense_* family
+ * @param reader Pointer to lre_reader_t
+ * @param src Pointer to key
+ * @param size Size of key
  */
 lre_decl
-uint8_t *lre_buffer_end(lre_buffer_t *buf) {
-	return buf->data + buf->size;
+void lre_reader_init(lre_reader_t *reader, const uint8_t *src, size_t size) {
+	reader->src = src;
+	reader->end = src + size;
 }
 
 
 /**
- * @brief Set size to pointer offset distance and terminate buffer with a null character.
- * @param buf Pointer to lre_buffer_t
- * @param end Pointer to buffer data (tupically from lre_buffer_end())
- * @return LRE_OK if success, LRE_FAIL otherwise
+ * @brief Check that all fields are read
+ * @return Non-zero if there are no more fields
  */
 lre_decl
-void lre_buffer_set_size_distance(lre_buffer_t *buf, const uint8_t *end) {
-	lre_debug("Zero at %i\n", (int) (end - buf->data + 1));
-
-	if (lre_likely(end >= buf->data)) {
-		buf->size = end - buf->data;
-		buf->data[buf->size] = '\0';
-	}
+int lre_reader_done(const lre_reader_t *reader) {
+	return reader->src >= reader->end;
 }
 
 
 /**
- * @brief Fast version of lre_buffer_reset without memory reallocations.
- * @param buf Pointer to lre_buffer_t
+ * @brief Read number into field
  */
 lre_decl
-void lre_buffer_reset_fast(lre_buffer_t *buf) {
-	buf->size = 0;
-	buf->data[0] = '\0';
+int lrex_reader_number(lre_tag_t tag, lre_slice_t *slice, lre_field_t *field, lre_error_t *error) {
+	lre_metanumber_t *num = &field->as.num;
+
+	if (lre_unlikely(lrex_tag_is_number_inf(tag))) {
+		field->type = LRE_TYPE_FLOAT;
+		field->as.f = lrex_tag_is_negative(tag) ? -INFINITY : INFINITY;
+		return LRE_OK;
+	}
+
+	if (lre_unlikely(lrex_read_metanumber(tag, slice, num, error) != LRE_OK)) {
+		return LRE_FAIL;
+	}
+
+	if (!num->fraction_data) {
+		uint64_t       integral;
+		const uint8_t *src = num->integral_data;
+
+		if (lre_unlikely(num->integral_nbytes > 8 || lrex_tag_is_number_big(tag))) {
+			field->type = LRE_TYPE_BIGINT;
+			return LRE_OK;
+		}
+
+		integral = lrex_read_uint64n(&src, num->integral_nbytes, num->negative_mask);
+
+		if (lre_unlikely(lrex_int_from_magnitude(integral, num->negative_mask, &field->as.i, error) != LRE_OK)) {
+			return LRE_FAIL;
+		}
+
+		field->type = LRE_TYPE_INT;
+		return LRE_OK;
+	}
+
+	{
+		uint64_t integral;
+		uint64_t fraction;
+		int      sticky;
+
+		if (lre_unlikely(lrex_number_fraction(num, &integral, &fraction, &sticky) != LRE_OK)) {
+			field->type = LRE_TYPE_BIGFLOAT;
+			return LRE_OK;
+		}
+
+		field->type = LRE_TYPE_FLOAT;
+		field->as.f = lrex_number_double(integral, fraction, num->fraction_exponent, sticky, num->negative_mask);
+	}
+
+	return LRE_OK;
 }
 
 
 /**
- * @brief Reallocate memory, reset size to 0 and terminate buffer with a null character.
- * @param buf Pointer to lre_buffer_t
+ * @brief Read next field. Check lre_reader_done() before the call.
+ * @param reader Pointer to lre_reader_t
+ * @param field Pointer to lre_field_t. Slices point into key or into reader
  * @param error Pointer to lre_error_t or 0
  * @return LRE_OK if success, LRE_FAIL otherwise
  */
 lre_decl
-int lre_buffer_reset(lre_buffer_t *buf, lre_error_t *error) {
-	lre_buffer_reset_fast(buf);
+int lre_reader_next(lre_reader_t *reader, lre_field_t *field, lre_error_t *error) {
+	const uint8_t *sep = lrex_memsep(reader->src, reader->end - reader->src);
+	lre_slice_t    slice;
 
-	if (lre_unlikely(buf->capacity != buf->reserved)) {
-		return lre_buffer_reallocate(buf, buf->reserved, error);
+	/* Also if field is not terminated */
+	if (lre_unlikely(!sep || sep == reader->src)) {
+		return lre_fail(LRE_ERROR_LENGTH, error);
 	}
-	
-	return LRE_OK;
+
+	field->tag  = (lre_tag_t) reader->src[0];
+	slice.src   = reader->src + 1;
+	slice.end   = sep;
+	reader->src = sep + 1;
+
+	if (lrex_tag_is_string(lrex_tag_regular(field->tag))) {
+		field->type = LRE_TYPE_STR;
+
+		if (lre_unlikely(lrex_read_string_enc(field->tag, &slice, &field->as.s.enc, error) != LRE_OK)) {
+			return LRE_FAIL;
+		}
+
+		field->as.s.slice = slice;
+		return LRE_OK;
+	}
+
+	if (lrex_tag_is_dense(field->tag)) {
+		lre_tag_t   regular = lrex_tag_regular(field->tag);
+		lre_slice_t hslice;
+
+		if (lre_unlikely(!lrex_tag_is_number(regular))) {
+			return lre_fail(LRE_ERROR_TAG, error);
+		}
+
+		if (lrex_tag_is_number_inf(regular)) {
+			return lrex_reader_number(regular, &slice, field, error);
+		}
+
+		if (lre_unlikely(lrex_transcode_dense_number(&slice, reader->hex, &hslice, error) != LRE_OK)) {
+			return LRE_FAIL;
+		}
+
+		return lrex_reader_number(regular, &hslice, field, error);
+	}
+
+	if (lre_unlikely(!lrex_tag_is_number(field->tag))) {
+		return lre_fail(LRE_ERROR_TAG, error);
+	}
+
+	return lrex_reader_number(field->tag, &slice, field, error);
 }
 
+
+/*
+ * SINGLE FIELD EXTRACTION.
+ * Earlier fields are skipped by separators only, without decoding.
+ */
+
 /**
- * @brief Free all buffer memory
- * @param buf Pointer to lre_buffer_t
+ * @brief Read one field of key created by lre_pack_* or lre_pack_dense_* family
+ * @param src Pointer to key
+ * @param size Size of key
+ * @param index Zero-based index of field
+ * @param reader Pointer to lre_reader_t, keeps transcoded dense numbers
+ * @param field Pointer to lre_field_t. Slices point into key or into reader
+ * @param error Pointer to lre_error_t or 0. LRE_ERROR_RANGE if there is no such field
+ * @return LRE_OK if success, LRE_FAIL otherwise
  */
 lre_decl
-void lre_buffer_close(lre_buffer_t *buf) {
-	lre_debug("%p\n", buf);
+int lre_get_field(const uint8_t *src, size_t size, size_t index,
+                  lre_reader_t *reader, lre_field_t *field, lre_error_t *error) {
+	const uint8_t *end = src + size;
 
-	if (buf) {
-		lre_std_free(buf->data);
-		lre_std_free(buf);
+	while (index--) {
+		const uint8_t *sep = lrex_memsep(src, end - src);
+
+		if (lre_unlikely(!sep)) {
+			return lre_fail(LRE_ERROR_RANGE, error);
+		}
+
+		src = sep + 1;
 	}
-}
 
-/*
- *
- */
+	lre_reader_init(reader, src, end - src);
+
+	if (lre_unlikely(lre_reader_done(reader))) {
+		return lre_fail(LRE_ERROR_RANGE, error);
+	}
+
+	return lre_reader_next(reader, field, error);
+}
 
 
 /**
- * @brief Write string into buffer
- * @param buf Pointer to lre_buffer_t
- * @param src Pointer to string
- * @param len Length of string
- * @param enc String encofing: LRE_ENC_RAW (also 0), LRE_ENC_UTF8
- * @param error Pointer to lre_error_t or 0
+ * @brief Read one integer field of key. Integral floats are integers too.
+ * @param out Pointer to result
+ * @param error Pointer to lre_error_t or 0. LRE_ERROR_TYPE if field is not integer,
+ * LRE_ERROR_RANGE if there is no such field or integer is big
  * @return LRE_OK if success, LRE_FAIL otherwise
  */
 lre_decl
-int lre_pack_str(lre_buffer_t *buf, const uint8_t *src, size_t len, lre_enc_t enc, lre_error_t *error) {
-	/* tag(1) + string(len*2) + encoding(1) + separator(1) */
-	if (lre_likely(lre_buffer_require(buf, (1+(len*2)+1+1), error) == LRE_OK)) {
-		uint8_t *dst = lre_buffer_end(buf);
-		
-		if (lre_unlikely(!enc)) {
-			enc = LRE_ENC_RAW;
-		}
+int lre_get_int(const uint8_t *src, size_t size, size_t index, int64_t *out, lre_error_t *error) {
+	lre_reader_t reader;
+	lre_field_t  field;
 
-		lrex_write_char(&dst, LRE_TAG_STRING);
-		lrex_write_str (&dst, src, len, 0);
-		lrex_write_char(&dst, (int) enc);
-		lrex_write_char(&dst, LRE_SEP_POSITIVE);
-		lre_buffer_set_size_distance(buf, dst);
-		return LRE_OK;
+	if (lre_unlikely(lre_get_field(src, size, index, &reader, &field, error) != LRE_OK)) {
+		return LRE_FAIL;
 	}
-	
-	return LRE_FAIL;
+
+	if (lre_unlikely(field.type != LRE_TYPE_INT)) {
+		return lre_fail((field.type == LRE_TYPE_BIGINT) ? LRE_ERROR_RANGE : LRE_ERROR_TYPE, error);
+	}
+
+	*out = field.as.i;
+	return LRE_OK;
 }
 
 
 /**
- * @brief Write 64-bit signed integer value into buffer
- * @param buf Pointer to lre_buffer_t
- * @param value Integer value
- * @param error Pointer to lre_error_t or 0
+ * @brief Read one number field of key as double. Integers are converted.
+ * @param out Pointer to result
+ * @param error Pointer to lre_error_t or 0. LRE_ERROR_TYPE if field is not number,
+ * LRE_ERROR_RANGE if there is no such field or number is beyond double range
  * @return LRE_OK if success, LRE_FAIL otherwise
  */
 lre_decl
-int lre_pack_int(lre_buffer_t *buf, int64_t value, lre_error_t *error) {
-	/* tag(1) + value(16) + separator(1) */
-	if (lre_likely(lre_buffer_require(buf, (1+16+1), error) == LRE_OK)) {
-		uint8_t *dst = lre_buffer_end(buf);
-		
-		if (value < 0) {
-			uint64_t uvalue = lrex_negate_negative(value);
-			uint8_t  nbytes = lrex_count_nbytes(uvalue);
-			
-			lrex_write_char   (&dst, (int) lrex_tag_by_nbytes_negative(nbytes));
-			lrex_write_uint64n(&dst, ~uvalue, nbytes);
-			lrex_write_char   (&dst, LRE_SEP_NEGATIVE);
-		}
-		else {
-			uint8_t nbytes = lrex_count_nbytes(value);
-			
-			lrex_write_char   (&dst, (int) lrex_tag_by_nbytes_positive(nbytes));
-			lrex_write_uint64n(&dst, value, nbytes);
-			lrex_write_char   (&dst, LRE_SEP_POSITIVE);
-		}
-		
-		lre_buffer_set_size_distance(buf, dst);
-		return LRE_OK;
+int lre_get_float(const uint8_t *src, size_t size, size_t index, double *out, lre_error_t *error) {
+	lre_reader_t reader;
+	lre_field_t  field;
+
+	if (lre_unlikely(lre_get_field(src, size, index, &reader, &field, error) != LRE_OK)) {
+		return LRE_FAIL;
+	}
+
+	switch (field.type) {
+		case LRE_TYPE_FLOAT:
+			*out = field.as.f;
+			return LRE_OK;
+
+		case LRE_TYPE_INT:
+			*out = (double) field.as.i;
+			return LRE_OK;
+
+		case LRE_TYPE_BIGINT:
+		case LRE_TYPE_BIGFLOAT:
+			/* E.g. lre_pack_float(1e20) */
+			return lrex_metanumber_double(&field.as.num, out, error);
+
+		default:
+			return lre_fail(LRE_ERROR_TYPE, error);
 	}
-	
-	return LRE_FAIL;
 }
 
 
 /**
- * @brief Write double value into buffer
- * @param buf Pointer to lre_buffer_t
- * @param value Double value
- * @param error Pointer to lre_error_t or 0
+ * @brief Decode one string field of key into buffer
+ * @param dst Destination
+ * @param len Pointer to size of destination, receives number of decoded bytes
+ * @param enc Pointer to lre_enc_t or 0, receives encoding of string
+ * @param error Pointer to lre_error_t or 0. LRE_ERROR_TYPE if field is not string,
+ * LRE_ERROR_ALLOCATION_SMALL if destination is too small (*len is set to required size)
  * @return LRE_OK if success, LRE_FAIL otherwise
  */
 lre_decl
-int lre_pack_float(lre_buffer_t *buf, double value, lre_error_t *error) {
-	if (lre_unlikely(lre_isnan(value))) {
-		return lre_fail(LRE_ERROR_NAN, error);
+int lre_get_str_into(const uint8_t *src, size_t size, size_t index,
+                     uint8_t *dst, size_t *len, lre_enc_t *enc, lre_error_t *error) {
+	lre_reader_t reader;
+	lre_field_t  field;
+	size_t       nbytes;
+
+	if (lre_unlikely(lre_get_field(src, size, index, &reader, &field, error) != LRE_OK)) {
+		return LRE_FAIL;
 	}
 
-	/* tag(1) + integral(16) + exp(4) + fraction(14) + separator(1) */
-	if (lre_likely(lre_buffer_require(buf, (1+16+(4+14)+1), error) == LRE_OK)) {
-		uint8_t *dst = lre_buffer_end(buf);
-		int negative = 0;
+	if (lre_unlikely(field.type != LRE_TYPE_STR)) {
+		return lre_fail(LRE_ERROR_TYPE, error);
+	}
 
-		if (lre_unlikely(lre_isinf(value))) {
-			if (value < 0) {
-				lrex_write_char(&dst, LRE_TAG_NUMBER_NEGATIVE_INF);
-			}
-			else {
-				lrex_write_char(&dst, LRE_TAG_NUMBER_POSITIVE_INF);
-			}
+	nbytes = lre_slice_str_nbytes(&field.as.s.slice, field.as.s.enc);
 
-			lre_buffer_set_size_distance(buf, dst);
-			return LRE_OK;
-		}
+	if (lre_unlikely(nbytes > *len)) {
+		*len = nbytes;
+		return lre_fail(LRE_ERROR_ALLOCATION_SMALL, error);
+	}
+
+	if (lre_unlikely(lre_slice_read_str(&field.as.s.slice, dst, field.as.s.enc) != LRE_OK)) {
+		return lre_fail(LRE_ERROR_CHAR, error);
+	}
+
+	if (enc) {
+		*enc = field.as.s.enc;
+	}
+
+	*len = nbytes;
+	return LRE_OK;
+}
 
-		if (lre_unlikely(value > 9007199254740991.0 || value < -9007199254740991.0)) {
-			return lre_fail(LRE_ERROR_RANGE, error);
-		}
 
-		if (value < 0.0) {
-			negative = 1;
-			value = -value;
-		}
+/*
+ * FIELD INDEX.
+ */
 
-		{
-			uint64_t integral        = value;
-			uint8_t  integral_nbytes = lrex_count_nbytes(integral);
+/* Part of key scanned for separators at once by lre_index_fields() */
+#define LRE_INDEX_BLOCK 512
 
-			int      exponent;
-			uint64_t mantissa        = ldexp(frexp(value - integral, &exponent), 53);
-			uint8_t  mantissa_nbytes = 7;
 
-			if (negative) {
-				lrex_write_char   (&dst, (int) lrex_tag_by_nbytes_negative(integral_nbytes));
-				lrex_write_uint64n(&dst, ~integral, integral_nbytes);
+/**
+ * @brief Locate fields of key in one pass without decoding. Slice of field spans from its tag
+ * (src[0]) to its separator (*end, also sign of number). Fields are not validated, any of them
+ * can be decoded with lre_reader_init(&reader, slice.src, lre_slice_len(&slice) + 1)
+ * and lre_reader_next().
+ * @param src Pointer to key
+ * @param size Size of key
+ * @param out Array of slices
+ * @param max Number of slices in array
+ * @return Number of found fields (at most max). Trailing data without separator is ignored
+ */
+lre_decl
+size_t lre_index_fields(const uint8_t *src, size_t size, lre_slice_t *out, size_t max) {
+	uint64_t       bits[LRE_INDEX_BLOCK / 64];
+	const uint8_t *start = src;
+	size_t         count = 0;
+	size_t         offset;
 
-				if (lre_likely(mantissa)) {
-					lrex_write_uint16 (&dst, ~(exponent + LRE_EXPONENT_BIAS));
-					lrex_write_uint64n(&dst, ~mantissa, mantissa_nbytes);
-				}
+	for (offset = 0; offset < size && count < max; offset += LRE_INDEX_BLOCK) {
+		size_t nbytes = (size - offset < LRE_INDEX_BLOCK) ? size - offset : LRE_INDEX_BLOCK;
+		size_t i;
 
-				lrex_write_char(&dst, LRE_SEP_NEGATIVE);
-			}
-			else {
-				lrex_write_char   (&dst, (int) lrex_tag_by_nbytes_positive(integral_nbytes));
-				lrex_write_uint64n(&dst, integral, integral_nbytes);
+		lrex_sepmask(src + offset, nbytes, bits);
 
-				if (lre_likely(mantissa)) {
-					lrex_write_uint16 (&dst, exponent + LRE_EXPONENT_BIAS);
-					lrex_write_uint64n(&dst, mantissa, mantissa_nbytes);
-				}
+		for (i = 0; i < (nbytes + 63) / 64; i++) {
+			uint64_t word = bits[i];
 
-				lrex_write_char(&dst, LRE_SEP_POSITIVE);
+			while (word && count < max) {
+				const uint8_t *sep = src + offset + i * 64 + lrex_ctz64(word);
+
+				out[count].src = start;
+				out[count].end = sep;
+				count++;
+
+				start = sep + 1;
+				word &= word - 1;
 			}
 		}
-
-		lre_buffer_set_size_distance(buf, dst);
-		return LRE_OK;
 	}
 
-	return LRE_FAIL;
+	return count;
 }
 
 
 /*
- * */
+ * COLUMNAR DECODE.
+ * Counterpart of lre_pack_columns(): keys with the same schema are decoded into arrays.
+ */
+
+/* Column of lre_unpack_columns(), type is part of schema */
 typedef struct {
-	lre_tag_t      tag;               /* Numeric tag */
-	uint8_t        negative_mask;     /* 0xff for negative numbers, 0 otherwise */
+	lre_type_t    type;
+	void         *data;    /* int64_t[] or double[], nrows values. Integers (also BIG) are converted to double */
+	size_t       *offsets; /* Offsets of strings in arena, nrows+1 (LRE_TYPE_STR only) */
+	lre_buffer_t *arena;   /* Decoded strings are appended (LRE_TYPE_STR only) */
+} lre_unpack_column_t;
 
-	const uint8_t *integral_data;     /* Pointer to integral */
-	uint16_t       integral_nbytes;   /* Number of bytes of integral part */
 
-	const uint8_t *fraction_data;     /* Pointer to fraction part (mantissa) */
-	uint16_t       fraction_nbytes;   /* Number of bytes of fraction part */
-	int32_t        fraction_exponent; /* Unbiased exponent of fraction part */
-} lre_metanumber_t;
+/**
+ * @brief Write field into row of column
+ * @return LRE_OK if success, LRE_FAIL if field does not match column or allocation failed
+ */
+lre_decl
+int lrex_unpack_column(lre_unpack_column_t *column, size_t r, lre_field_t *field, lre_error_t *error) {
+	switch (column->type) {
+		case LRE_TYPE_INT:
+			if (lre_unlikely(field->type != LRE_TYPE_INT)) {
+				return lre_fail(LRE_ERROR_TYPE, error);
+			}
 
+			((int64_t *) column->data)[r] = field->as.i;
+			return LRE_OK;
 
-typedef struct lre_loader_t lre_loader_t;
+		case LRE_TYPE_FLOAT:
+			if (lre_likely(field->type == LRE_TYPE_FLOAT)) {
+				((double *) column->data)[r] = field->as.f;
+				return LRE_OK;
+			}
 
-/* LRE end handlers for unpack.
- * Normally, it is long-lived objects. */
-typedef struct lre_loader_t {
-	void *app_private;
-	int (*handler_int)     (lre_loader_t *loader, int64_t value);
-	int (*handler_float)   (lre_loader_t *loader, double value);
-	int (*handler_inf)     (lre_loader_t *loader, lre_tag_t tag);
-	int (*handler_str)     (lre_loader_t *loader, lre_slice_t *slice, lre_enc_t enc);
-	int (*handler_bigint)  (lre_loader_t *loader, const lre_metanumber_t *num);
-	int (*handler_bigfloat)(lre_loader_t *loader, const lre_metanumber_t *num);
-} lre_loader_t;
+			/* lre_pack_columns() writes |x| >= 2^63 as BIG */
+			if (field->type == LRE_TYPE_BIGINT) {
+				return lrex_metanumber_double(&field->as.num, &((double *) column->data)[r], error);
+			}
 
+			if (lre_unlikely(field->type != LRE_TYPE_INT)) {
+				return lre_fail(LRE_ERROR_TYPE, error);
+			}
 
-lre_decl
-int lre_loader_default_handler_int(lre_loader_t *loader, int64_t value) {
-	lre_debug("call\n");
-	return LRE_FAIL;
-}
+			((double *) column->data)[r] = (double) field->as.i;
+			return LRE_OK;
 
+		case LRE_TYPE_STR: {
+			lre_buffer_t *arena = column->arena;
+			size_t        nbytes;
 
-lre_decl
-int lre_loader_default_handler_float(lre_loader_t *loader, double value) {
-	lre_debug("call\n");
-	return LRE_FAIL;
-}
+			if (lre_unlikely(field->type != LRE_TYPE_STR)) {
+				return lre_fail(LRE_ERROR_TYPE, error);
+			}
 
+			nbytes = lre_slice_str_nbytes(&field->as.s.slice, field->as.s.enc);
 
-lre_decl
-int lre_loader_default_handler_str(lre_loader_t *loader, lre_slice_t *slice, lre_enc_t enc) {
-	lre_debug("call\n");
-	return LRE_FAIL;
-}
+			if (lre_unlikely(lre_buffer_require(arena, nbytes, error) != LRE_OK)) {
+				return LRE_FAIL;
+			}
 
+			if (lre_unlikely(lre_slice_read_str(&field->as.s.slice, lre_buffer_end(arena), field->as.s.enc) != LRE_OK)) {
+				return lre_fail(LRE_ERROR_CHAR, error);
+			}
 
-lre_decl
-int lre_loader_default_handler_inf(lre_loader_t *loader, lre_tag_t tag) {
-	double value = lrex_tag_is_negative(tag) ? -INFINITY : INFINITY;
-	lre_debug("call\n");
+			arena->size += nbytes;
+			column->offsets[r + 1] = arena->size;
+			return LRE_OK;
+		}
 
-	if (lre_likely(loader->handler_float)) {
-		return loader->handler_float(loader, value);
+		default:
+			return lre_fail(LRE_ERROR_TYPE, error);
 	}
-
-	return LRE_OK;
-}
-
-
-lre_decl
-int lre_loader_default_handler_bigint(lre_loader_t *loader, const lre_metanumber_t *num) {
-	lre_debug("call\n");
-	return LRE_FAIL;
 }
 
 
+/**
+ * @brief Decode keys created by lre_pack_* or lre_pack_dense_* family into columns (struct of arrays).
+ *
+ * Key of row r is keys[r]. Row that does not match schema (number of fields, types,
+ * invalid or big values) is marked in mismatch bitmap, its numbers are set to zero
+ * and its strings are empty.
+ *
+ * @param keys Array of keys
+ * @param nrows Number of keys
+ * @param columns Array of columns, one per field
+ * @param ncolumns Number of columns
+ * @param mismatch Bitmap of (nrows+63)/64 words (output), bit r%64 of word r/64 is row r
+ * @param error Pointer to lre_error_t or 0
+ * @return LRE_OK if success (even if some rows mismatch), LRE_FAIL otherwise
+ * (LRE_ERROR_TYPE if column type is not LRE_TYPE_INT, LRE_TYPE_FLOAT or LRE_TYPE_STR)
+ */
 lre_decl
-int lre_loader_default_handler_bigfloat(lre_loader_t *loader, const lre_metanumber_t *num) {
-	lre_debug("call\n");
-	return LRE_FAIL;
-}
-
+int lre_unpack_columns(const lre_slice_t *keys, size_t nrows, lre_unpack_column_t *columns, size_t ncolumns,
+                       uint64_t *mismatch, lre_error_t *error) {
+	lre_reader_t reader;
+	lre_field_t  field;
+	size_t       c;
+	size_t       r;
+
+	for (c = 0; c < ncolumns; c++) {
+		lre_unpack_column_t *column = &columns[c];
+
+		switch (column->type) {
+			case LRE_TYPE_INT:
+			case LRE_TYPE_FLOAT:
+				if (lre_unlikely(!column->data)) {
+					return lre_fail(LRE_ERROR_NULLPTR, error);
+				}
 
-lre_decl
-void lre_loader_init(lre_loader_t *loader, void *app_private) {
-	loader->app_private      = app_private;
+				break;
 
-	loader->handler_int      = &lre_loader_default_handler_int;
-	loader->handler_float    = &lre_loader_default_handler_float;
-	loader->handler_str      = &lre_loader_default_handler_str;
-	loader->handler_inf      = &lre_loader_default_handler_inf;
-	loader->handler_bigint   = &lre_loader_default_handler_bigint;
-	loader->handler_bigfloat = &lre_loader_default_handler_bigfloat;
-}
+			case LRE_TYPE_STR:
+				if (lre_unlikely(!column->offsets || !column->arena)) {
+					return lre_fail(LRE_ERROR_NULLPTR, error);
+				}
 
+				break;
 
-lre_decl // TODO
-int lre_load_string(lre_loader_t *loader, lre_tag_t tag, lre_slice_t *slice, lre_error_t *error) {
-	lre_enc_t encoding;
-	
-	if (lre_unlikely((lre_slice_len(slice) - 1) % 2)) {
-		return lre_fail(LRE_ERROR_LENGTH, error);
-	}
-	
-	/* Last character is a encoding value */
-	encoding = (lre_enc_t) lre_slice_pop(slice);
-	
-	switch (encoding) {
-		case LRE_ENC_UTF8: break;
-		case LRE_ENC_RAW:  break;
-		default: return lre_fail(LRE_ERROR_ENC, error);
+			default:
+				/* Big numbers have no column representation */
+				return lre_fail(LRE_ERROR_TYPE, error);
+		}
 	}
-	
-	if (lre_unlikely(loader->handler_str(loader, slice, encoding) != LRE_OK)) {
-		return lre_fail(LRE_ERROR_HANDLER, error);
+
+	/* Schema is valid, nothing is written before */
+	for (c = 0; c < ncolumns; c++) {
+		if (columns[c].type == LRE_TYPE_STR) {
+			columns[c].offsets[0] = columns[c].arena->size;
+		}
 	}
-	
-	return LRE_OK;
-}
 
+	memset(mismatch, 0, (nrows + 63) / 64 * sizeof(uint64_t));
 
-lre_decl
-int lrex_load_number_integer(lre_loader_t *loader, const lre_metanumber_t *num, lre_error_t *error) {
-	uint64_t integral;
-	const uint8_t *src = num->integral_data;
+	for (r = 0; r < nrows; r++) {
+		lre_error_t check = LRE_ERROR_NOTHING;
 
-	if (lre_unlikely(num->integral_nbytes > 8 || lrex_tag_is_number_big(num->tag))) {
-		if (lre_unlikely(loader->handler_bigint(loader, num) != LRE_OK)) {
-			return lre_fail(LRE_ERROR_HANDLER, error);
+		if (lre_likely(r + 1 < nrows)) {
+			lre_prefetch(keys[r + 1].src);
 		}
 
-		return LRE_OK;
-	}
+		lre_reader_init(&reader, keys[r].src, lre_slice_len(&keys[r]));
 
-	integral = lrex_read_uint64n(&src, num->integral_nbytes, num->negative_mask);
+		for (c = 0; c < ncolumns; c++) {
+			if (lre_unlikely(lre_reader_done(&reader))) {
+				break;
+			}
 
-	if (num->negative_mask) {
-		if (lre_unlikely(integral > UINT64_C(9223372036854775808))) {
-			return lre_fail(LRE_ERROR_RANGE, error);
-		}
+			if (lre_unlikely(lre_reader_next(&reader, &field, &check) != LRE_OK)) {
+				break;
+			}
 
-		if (lre_unlikely(loader->handler_int(loader, lrex_negate_positive(integral)) != LRE_OK)) {
-			return lre_fail(LRE_ERROR_HANDLER, error);
+			if (lre_unlikely(lrex_unpack_column(&columns[c], r, &field, &check) != LRE_OK)) {
+				break;
+			}
 		}
-	}
-	else {
-		if (lre_unlikely(integral > UINT64_C(9223372036854775807))) {
-			return lre_fail(LRE_ERROR_RANGE, error);
+
+		if (lre_unlikely(check == LRE_ERROR_ALLOCATION || check == LRE_ERROR_ALLOCATION_SMALL)) {
+			return lre_fail(check, error);
 		}
 
-		if (lre_unlikely(loader->handler_int(loader, integral) != LRE_OK)) {
-			return lre_fail(LRE_ERROR_HANDLER, error);
+		if (lre_likely(c == ncolumns && lre_reader_done(&reader))) {
+			continue;
 		}
-	}
 
-	return LRE_OK;
-}
+		mismatch[r / 64] |= UINT64_C(1) << (r % 64);
 
+		for (c = 0; c < ncolumns; c++) {
+			lre_unpack_column_t *column = &columns[c];
 
-lre_decl
-int lrex_load_number_float(lre_loader_t *loader, const lre_metanumber_t *num, lre_error_t *error) {
-	uint64_t integral;
-	uint64_t fraction;
-	double value;
+			switch (column->type) {
+				case LRE_TYPE_INT:
+					((int64_t *) column->data)[r] = 0;
+					break;
 
-	if (lre_unlikely(num->integral_nbytes > 7 || num->fraction_nbytes > 7)) {
-		goto handle_bigfloat;
-	}
+				case LRE_TYPE_FLOAT:
+					((double *) column->data)[r] = 0;
+					break;
 
-	if (lre_unlikely(num->fraction_exponent > 0 || num->fraction_exponent < -1073)) {
-		goto handle_bigfloat;
-	}
+				case LRE_TYPE_STR:
+					column->arena->size    = column->offsets[r];
+					column->offsets[r + 1] = column->offsets[r];
+					break;
 
-	{
-		const uint8_t *isrc = num->integral_data;
-		const uint8_t *fsrc = num->fraction_data;
-		integral = lrex_read_uint64n(&isrc, num->integral_nbytes, num->negative_mask);
-		fraction = lrex_read_uint64n(&fsrc, num->fraction_nbytes, num->negative_mask);
+				default:
+					break;
+			}
+		}
 	}
 
-	if (lre_unlikely(integral > INT64_C(9007199254740991) || fraction > INT64_C(9007199254740991))) {
-		goto handle_bigfloat;
-	}
+	return LRE_OK;
+}
 
-	value = integral;
 
-	if (lre_likely(fraction)) {
-		int nbits = lrex_log2i(fraction) + 1;
-		double f = ldexp(ldexp(fraction, -nbits), num->fraction_exponent);
+/*
+ * VALIDATION.
+ * Keys from untrusted sources are checked without producing values.
+ */
 
-		value += f;
+/**
+ * @brief Check layout of regular number payload: BIG header, integral part, exponent and fraction
+ * @param tag Numeric tag (without INF tags)
+ * @param slice Payload of number, nibble alphabet is already checked
+ * @param error Pointer to lre_error_t or 0
+ * @return LRE_OK if success, LRE_FAIL otherwise
+ */
+lre_decl
+int lrex_validate_number(lre_tag_t tag, lre_slice_t *slice, lre_error_t *error) {
+	lre_metanumber_t num;
 
-		if (lre_unlikely(value - integral != f)) {
-			goto handle_bigfloat;
-		}
+	if (lre_unlikely(lrex_read_metanumber(tag, slice, &num, error) != LRE_OK)) {
+		return LRE_FAIL;
 	}
 
-	if (num->negative_mask) {
-		value = -value;
+	/* Empty BIG is never packed */
+	if (lre_unlikely(lrex_tag_is_number_big(tag) && !num.integral_nbytes)) {
+		return lre_fail(LRE_ERROR_LENGTH, error);
 	}
 
-	if (lre_unlikely(loader->handler_float(loader, value) != LRE_OK)) {
-		return lre_fail(LRE_ERROR_HANDLER, error);
-	}
+	/* Integers beyond 64-bit range are packed as BIG */
+	if (!num.fraction_data && !lrex_tag_is_number_big(tag) && num.integral_nbytes == 8) {
+		const uint8_t *src      = num.integral_data;
+		uint64_t       integral = lrex_read_uint64n(&src, 8, num.negative_mask);
+		int64_t        value;
 
-	return LRE_OK;
+		if (lre_unlikely(lrex_int_from_magnitude(integral, num.negative_mask, &value, error) != LRE_OK)) {
+			return LRE_FAIL;
+		}
+	}
 
-handle_bigfloat:
-	if (lre_unlikely(loader->handler_bigfloat(loader, num) != LRE_OK)) {
-		return lre_fail(LRE_ERROR_HANDLER, error);
+	/* Nothing after integral part or at least one byte of fraction */
+	if (num.fraction_data ? (lre_slice_len(slice) < 2 || lre_slice_len(slice) % 2) : lre_slice_len(slice) != 0) {
+		return lre_fail(LRE_ERROR_LENGTH, error);
 	}
 
 	return LRE_OK;
 }
 
 
-lre_decl // TODO
-int lre_load_number(lre_loader_t *loader, lre_tag_t tag, lre_slice_t *slice, lre_error_t *error) {
-	lre_metanumber_t num = {0};
+/**
+ * @brief Check one field
+ * @param tag Tag of field
+ * @param sep Separator of field
+ * @param slice Payload of field
+ * @param hex Destination with LRE_TRANSCODE_NUMBER_MAX*2 of space for dense numbers
+ * @param error Pointer to lre_error_t or 0
+ * @return LRE_OK if success, LRE_FAIL otherwise
+ */
+lre_decl
+int lrex_validate_field(lre_tag_t tag, uint8_t sep, lre_slice_t *slice, uint8_t *hex, lre_error_t *error) {
+	lre_tag_t regular = lrex_tag_regular(tag);
 
-	if (lre_unlikely(lrex_tag_is_number_inf(tag))) {
-		if (lre_unlikely(loader->handler_inf(loader, tag) != LRE_OK)) {
-			return lre_fail(LRE_ERROR_HANDLER, error);
+	if (lrex_tag_is_string(regular)) {
+		lre_enc_t enc;
+		uint8_t   first = lrex_tag_is_dense(tag) ? LRE_DENSE_FIRST : 'a';
+		uint8_t   last  = lrex_tag_is_dense(tag) ? LRE_DENSE_FIRST + 63 : 'p';
+
+		if (lre_unlikely(sep != LRE_SEP_POSITIVE)) {
+			return lre_fail(LRE_ERROR_SIGN, error);
+		}
+
+		if (lre_unlikely(lrex_read_string_enc(tag, slice, &enc, error) != LRE_OK)) {
+			return LRE_FAIL;
+		}
+
+		if (lre_unlikely(lrex_check_range(slice->src, lre_slice_len(slice), first, last) != LRE_OK)) {
+			return lre_fail(LRE_ERROR_CHAR, error);
 		}
 
 		return LRE_OK;
 	}
 
-	num.tag = tag;
-	num.negative_mask = 0xff * lrex_tag_is_negative(tag);
+	if (lre_unlikely(!lrex_tag_is_number(regular))) {
+		return lre_fail(LRE_ERROR_TAG, error);
+	}
+
+	if (lre_unlikely(sep != (lrex_tag_is_negative(regular) ? LRE_SEP_NEGATIVE : LRE_SEP_POSITIVE))) {
+		return lre_fail(LRE_ERROR_SIGN, error);
+	}
 
-	if (lre_unlikely(lrex_tag_is_number_big(tag))) {
-		if (lre_unlikely(lre_slice_len(slice) < 4)) {
+	if (lrex_tag_is_number_inf(regular)) {
+		if (lre_unlikely(lre_slice_len(slice) != 0)) {
 			return lre_fail(LRE_ERROR_LENGTH, error);
 		}
 
-		num.integral_nbytes = lrex_read_uint16(&slice->src, num.negative_mask);
-	}
-	else if (num.negative_mask) {
-		num.integral_nbytes = lrex_nbytes_by_tag_negative(tag);
-	}
-	else {
-		num.integral_nbytes = lrex_nbytes_by_tag_positive(tag);
+		return LRE_OK;
 	}
 
-	if (lre_unlikely(num.integral_nbytes * 2 > lre_slice_len(slice))) {
-		return lre_fail(LRE_ERROR_LENGTH, error);
-	}
+	if (lrex_tag_is_dense(tag)) {
+		lre_slice_t hslice;
 
-	num.integral_data = slice->src;
-	slice->src += num.integral_nbytes * 2;
+		/* Alphabet is checked by transcoding */
+		if (lre_unlikely(lrex_transcode_dense_number(slice, hex, &hslice, error) != LRE_OK)) {
+			return LRE_FAIL;
+		}
 
-	if (lre_slice_len(slice) < 4) {
-		return lrex_load_number_integer(loader, &num, error);
+		return lrex_validate_number(regular, &hslice, error);
 	}
 
-	num.fraction_exponent = lrex_read_uint16(&slice->src, num.negative_mask);
-	num.fraction_exponent -= LRE_EXPONENT_BIAS;
-	num.fraction_data = slice->src;
-	num.fraction_nbytes = lre_slice_len(slice) / 2;
+	if (lre_unlikely(lrex_check_range(slice->src, lre_slice_len(slice), 'a', 'p') != LRE_OK)) {
+		return lre_fail(LRE_ERROR_CHAR, error);
+	}
 
-	return lrex_load_number_float(loader, &num, error);
+	return lrex_validate_number(regular, slice, error);
 }
 
 
 /**
- * @brief Load values from string that created by lre_pack_* family
- * @param loader Pointer to lre_loader_t
- * @param src Pointer to string
- * @param size Size of string
+ * @brief Check key created by lre_pack_* or lre_pack_dense_* family without producing values:
+ * tags, separators against signs, string encodings and lengths, alphabets, BIG headers
+ * and layout of numbers. Binary keys are not supported.
+ * @param src Pointer to key
+ * @param size Size of key
  * @param error Pointer to lre_error_t or 0
- * @return LRE_OK if success, LRE_FAIL otherwise
+ * @param offset Pointer to offset of invalid field or 0
+ * @return LRE_OK if key is valid, LRE_FAIL otherwise
  */
 lre_decl
-int lre_tokenize(lre_loader_t *loader, const uint8_t *src, size_t size, lre_error_t *error) {
-	const uint8_t *sep = src;
-	const uint8_t *end = src + size;
-	
-	while ((sep = lrex_memsep(src, end - sep))) {
-		lre_tag_t   tag   = (lre_tag_t) lrex_read_char(&src);
-		lre_slice_t slice = {src, sep};
-
-		src = sep + 1;
-		
-		if (lre_unlikely(lre_slice_len(&slice) < 0)) {
-			return lre_fail(LRE_ERROR_LENGTH, error);
+int lre_validate(const uint8_t *src, size_t size, lre_error_t *error, size_t *offset) {
+	const uint8_t *start = src;
+	const uint8_t *end   = src + size;
+	lre_error_t    check = LRE_ERROR_NOTHING;
+	uint8_t        hex[LRE_TRANSCODE_NUMBER_MAX * 2];
+
+	while (src < end) {
+		const uint8_t *sep = lrex_memsep(src, end - src);
+		lre_slice_t    slice;
+
+		/* Also if field is not terminated */
+		if (lre_unlikely(!sep || sep == src)) {
+			check = LRE_ERROR_LENGTH;
+			break;
 		}
 
-		if (lrex_tag_is_string(tag)) {
-			if (lre_unlikely(lre_load_string(loader, tag, &slice, error) != LRE_OK)) {
-				return LRE_FAIL;
-			}
-			
-			continue;
+		slice.src = src + 1;
+		slice.end = sep;
+
+		if (lre_unlikely(lrex_validate_field((lre_tag_t) src[0], *sep, &slice, hex, &check) != LRE_OK)) {
+			break;
 		}
-		
-		if (lrex_tag_is_number(tag)) {
-			if (lre_unlikely(lre_load_number(loader, tag, &slice, error) != LRE_OK)) {
-				return LRE_FAIL;
-			}
-			
-			continue;
+
+		src = sep + 1;
+	}
+
+	if (lre_unlikely(check != LRE_ERROR_NOTHING)) {
+		if (offset) {
+			*offset = src - start;
 		}
-		
-		return lre_fail(LRE_ERROR_TAG, error);
+
+		return lre_fail(check, error);
 	}
 
 	return LRE_OK;
@@ -4,3 +4,6 @@ lre_object = LRE(2048)
 dumps = lre_object.pack
 loads = lre_object.load
 
+dumps_dense = lre_object.pack_dense
+dumps_bin = lre_object.pack_bin
+loads_bin = lre_object.load_bin
@@ -27,6 +27,8 @@ cdef extern from 'lre.h':
 		LRE_ERROR_SIGN
 		LRE_ERROR_ENC
 		LRE_ERROR_HANDLER
+		LRE_ERROR_CHAR
+		LRE_ERROR_TYPE
 
 	cdef enum lre_sep_t:
 		LRE_SEP_NEGATIVE
@@ -59,11 +61,16 @@ cdef extern from 'lre.h':
 		LRE_ENC_NONE
 		LRE_ENC_RAW
 		LRE_ENC_UTF8
+		LRE_ENC_DENSE_RAW
+		LRE_ENC_DENSE_UTF8
+		LRE_ENC_BIN_RAW
+		LRE_ENC_BIN_UTF8
 
 	void     lrex_write_char(uint8_t **dst, uint8_t value)
 	void     lrex_write_uint16(uint8_t **dst, uint16_t value)
 	void     lrex_write_str(uint8_t **dst, const uint8_t *src, size_t len, uint8_t mask)
 	void     lrex_read_str(const uint8_t **src, uint8_t *dst, size_t nbytes, uint8_t mask)
+	int      lrex_read_str_checked(const uint8_t **src, uint8_t *dst, size_t nbytes, uint8_t mask)
 	uint64_t lrex_read_uint64n(const uint8_t **src, size_t nbytes, uint8_t mask)
 
 	ctypedef struct lre_buffer_t:
@@ -83,12 +90,26 @@ cdef extern from 'lre.h':
 	int lre_pack_str(lre_buffer_t *buf, const uint8_t *src, size_t len, lre_enc_t enc, lre_error_t *error)
 	int lre_pack_int(lre_buffer_t *buf, int64_t value, lre_error_t *error)
 	int lre_pack_float(lre_buffer_t *buf, double value, lre_error_t *error)
+	int lre_pack_float_compact(lre_buffer_t *buf, double value, lre_error_t *error)
+	int lre_pack_bigint(lre_buffer_t *buf, const uint8_t *magnitude, size_t n, int negative, lre_error_t *error)
+	int lre_pack_decimal_str(lre_buffer_t *buf, const uint8_t *src, size_t len, lre_error_t *error)
+
+	int lre_pack_dense_str(lre_buffer_t *buf, const uint8_t *src, size_t len, lre_enc_t enc, lre_error_t *error)
+	int lre_pack_dense_int(lre_buffer_t *buf, int64_t value, lre_error_t *error)
+	int lre_pack_dense_float(lre_buffer_t *buf, double value, lre_error_t *error)
+	int lre_pack_dense_float_compact(lre_buffer_t *buf, double value, lre_error_t *error)
+
+	int lre_pack_bin_str(lre_buffer_t *buf, const uint8_t *src, size_t len, lre_enc_t enc, lre_error_t *error)
+	int lre_pack_bin_int(lre_buffer_t *buf, int64_t value, lre_error_t *error)
+	int lre_pack_bin_float(lre_buffer_t *buf, double value, lre_error_t *error)
 
 	ctypedef struct lre_slice_t:
 		const uint8_t *src
 		const uint8_t *end
 
 	ptrdiff_t lre_slice_len(const lre_slice_t *slice)
+	size_t    lre_slice_str_nbytes(const lre_slice_t *slice, lre_enc_t enc)
+	int       lre_slice_read_str(lre_slice_t *slice, uint8_t *dst, lre_enc_t enc)
 
 	ctypedef struct lre_metanumber_t:
 		lre_tag_t      tag
@@ -99,6 +120,13 @@ cdef extern from 'lre.h':
 		uint16_t       fraction_nbytes
 		int32_t        fraction_exponent
 
+	int lre_metanumber_read_integral(const lre_metanumber_t *num, uint8_t *dst, lre_error_t *error)
+
+	ctypedef struct lre_decimal_t:
+		uint64_t coefficient
+		int32_t  exponent
+		uint8_t  negative
+
 	ctypedef struct lre_loader_t:
 		void *app_private
 		int (*handler_int)     (lre_loader_t *loader, int64_t value) except? LRE_FAIL
@@ -107,9 +135,11 @@ cdef extern from 'lre.h':
 		int (*handler_inf)     (lre_loader_t *loader, lre_tag_t tag) except? LRE_FAIL
 		int (*handler_bigint)  (lre_loader_t *loader, const lre_metanumber_t *num) except? LRE_FAIL
 		int (*handler_bigfloat)(lre_loader_t *loader, const lre_metanumber_t *num) except? LRE_FAIL
+		int (*handler_decimal) (lre_loader_t *loader, const lre_decimal_t *dec) except? LRE_FAIL
 
 	void lre_loader_init(lre_loader_t *loader, void *app_private)
 	int  lre_tokenize(lre_loader_t *loader, const uint8_t *src, size_t size, lre_error_t *error) except? LRE_FAIL
+	int  lre_tokenize_bin(lre_loader_t *loader, const uint8_t *src, size_t size, lre_error_t *error) except? LRE_FAIL
 
 	const char *lre_strerror(lre_error_t error)
 
@@ -119,14 +149,27 @@ cdef class LRE:
 	cdef lre_buffer_t *lrbuffer
 	cdef lre_loader_t  lrloader
 	cdef list          tmpkey
+	cdef bint          compact
 
 	cpdef pack(self, key)
 
+	cpdef pack_dense(self, key)
+
+	cpdef pack_bin(self, key)
+
 	cpdef load(self, key)
+
+	cpdef load_bin(self, key)
+
+	cdef buffer_pack(self, key, int fmt)
+
+	cdef buffer_load(self, key, int fmt)
 	
-	cdef buffer_write(self, key, int depth)
+	cdef buffer_write(self, key, int depth, int fmt)
+
+	cdef buffer_write_str(self, const uint8_t *str_value, Py_ssize_t str_size, lre_enc_t enc, int fmt)
 
-	cdef buffer_write_int(self, pyint)
+	cdef buffer_write_int(self, pyint, int fmt)
 
 	@staticmethod # Call by lre_tokenize()
 	cdef int callback_load_int(lre_loader_t *loader, int64_t value) except? LRE_FAIL
@@ -140,8 +183,5 @@ cdef class LRE:
 	@staticmethod # Call by lre_tokenize()
 	cdef int callback_load_bigint(lre_loader_t *loader, const lre_metanumber_t *num) except? LRE_FAIL
 
-
-
-
-
-
+	@staticmethod # Call by lre_tokenize()
+	cdef int callback_load_decimal(lre_loader_t *loader, const lre_decimal_t *dec) except? LRE_FAIL
@@ -1,5 +1,7 @@
 cimport cython
 
+from decimal import Decimal
+
 
 cdef extern from *:
 	ctypedef struct PyObject
@@ -26,15 +28,22 @@ cdef extern from *:
 DEF LRE_OK   = 0
 DEF LRE_FAIL = 1
 
+# Formats of LRE.buffer_write()
+DEF FORMAT_TEXT  = 0
+DEF FORMAT_DENSE = 1
+DEF FORMAT_BIN   = 2
+
 # Thanks to GIL we can avoid memory allocation
 cdef uint8_t TMP65535[65535]
 
 
 @cython.final
 cdef class LRE:
-	def __cinit__(self, int reserve):
+	def __cinit__(self, int reserve, bint compact=False, bint decimal=False):
 		cdef lre_error_t error = LRE_ERROR_NOTHING
 
+		self.compact = compact
+
 		self.lrbuffer = lre_buffer_create(reserve, &error)
 
 		if error:
@@ -46,20 +55,39 @@ cdef class LRE:
 		self.lrloader.handler_str    = &self.callback_load_str
 		self.lrloader.handler_bigint = &self.callback_load_bigint
 
+		if decimal:
+			self.lrloader.handler_decimal = &self.callback_load_decimal
+
 	cpdef pack(self, key):
+		return self.buffer_pack(key, FORMAT_TEXT)
+
+	cpdef pack_dense(self, key):
+		return self.buffer_pack(key, FORMAT_DENSE)
+
+	cpdef pack_bin(self, key):
+		return self.buffer_pack(key, FORMAT_BIN)
+
+	cpdef load(self, key):
+		return self.buffer_load(key, FORMAT_TEXT)
+
+	cpdef load_bin(self, key):
+		return self.buffer_load(key, FORMAT_BIN)
+
+	cdef buffer_pack(self, key, int fmt):
 		cdef lre_error_t error = LRE_ERROR_NOTHING
 		lre_buffer_reset_fast(self.lrbuffer)
 
 		try:
-			self.buffer_write(key, 0)
+			self.buffer_write(key, 0, fmt)
 			return (<char *> self.lrbuffer.data)[:self.lrbuffer.size]
 		finally:
 			if lre_buffer_reset(self.lrbuffer, &error) != LRE_OK:
 				raise MemoryError(lre_strerror(error).decode('utf8'))
 
-	cpdef load(self, key):
+	cdef buffer_load(self, key, int fmt):
 		cdef lre_error_t error = LRE_ERROR_NOTHING
 		cdef const char *src
+		cdef int         result
 
 		try:
 			self.tmpkey = []
@@ -72,14 +100,19 @@ cdef class LRE:
 			else:
 				raise TypeError("a bytes or unicode object is required, not '%s'" % type(key).__name__)
 
-			if lre_tokenize(&self.lrloader, <uint8_t *> src, len(key), &error) != LRE_OK:
+			if fmt == FORMAT_BIN:
+				result = lre_tokenize_bin(&self.lrloader, <uint8_t *> src, len(key), &error)
+			else:
+				result = lre_tokenize(&self.lrloader, <uint8_t *> src, len(key), &error)
+
+			if result != LRE_OK:
 				raise ValueError(lre_strerror(error).decode('utf8'))
 
 			return self.tmpkey
 		finally:
 			self.tmpkey = []
 
-	cdef buffer_write(self, key, int depth):
+	cdef buffer_write(self, key, int depth, int fmt):
 		cdef lre_error_t    error = LRE_ERROR_NOTHING
 		cdef const uint8_t *str_value
 		cdef Py_ssize_t     str_size
@@ -93,20 +126,39 @@ cdef class LRE:
 		for i in key:
 			if isinstance(i, unicode):
 				str_value = <const uint8_t *> PyUnicode_AsUTF8AndSize(i, &str_size)
-				lre_pack_str(self.lrbuffer, str_value, str_size, LRE_ENC_UTF8, &error)
+				self.buffer_write_str(str_value, str_size, LRE_ENC_UTF8, fmt)
 
 			elif isinstance(i, float):
-				lre_pack_float(self.lrbuffer, i, &error)
+				if fmt == FORMAT_DENSE:
+					if self.compact:
+						lre_pack_dense_float_compact(self.lrbuffer, i, &error)
+					else:
+						lre_pack_dense_float(self.lrbuffer, i, &error)
+				elif fmt == FORMAT_BIN:
+					lre_pack_bin_float(self.lrbuffer, i, &error)
+				elif self.compact:
+					lre_pack_float_compact(self.lrbuffer, i, &error)
+				else:
+					lre_pack_float(self.lrbuffer, i, &error)
 
 			elif isinstance(i, int):
-				self.buffer_write_int(i)
+				self.buffer_write_int(i, fmt)
 	
 			elif isinstance(i, bytes):
 				PyBytes_AsStringAndSize(i, <char **> &str_value, &str_size)
-				lre_pack_str(self.lrbuffer, str_value, str_size, LRE_ENC_RAW, &error)
+				self.buffer_write_str(str_value, str_size, LRE_ENC_RAW, fmt)
 	
+			elif isinstance(i, Decimal) and fmt == FORMAT_TEXT and not self.compact:
+				# Coefficient is 64-bit, integral decimals of any size are integers
+				if i.is_finite() and len(i.as_tuple().digits) > 19 and i == i.to_integral_value():
+					self.buffer_write_int(int(i), fmt)
+				else:
+					str_bytes = str(i).encode('ascii')
+					PyBytes_AsStringAndSize(str_bytes, <char **> &str_value, &str_size)
+					lre_pack_decimal_str(self.lrbuffer, str_value, str_size, &error)
+
 			elif isinstance(i, list):
-				self.buffer_write(i, depth + 1)
+				self.buffer_write(i, depth + 1, fmt)
 	
 			else:
 				raise ValueError('type <%s> is unsupported' % type(i).__name__)
@@ -114,46 +166,56 @@ cdef class LRE:
 			if error:
 				raise ValueError(lre_strerror(error).decode('utf8'))
 
-	cdef buffer_write_int(self, pyint):
+	cdef buffer_write_str(self, const uint8_t *str_value, Py_ssize_t str_size, lre_enc_t enc, int fmt):
+		cdef lre_error_t error = LRE_ERROR_NOTHING
+		cdef int         result
+
+		if fmt == FORMAT_DENSE:
+			result = lre_pack_dense_str(self.lrbuffer, str_value, str_size, enc, &error)
+		elif fmt == FORMAT_BIN:
+			result = lre_pack_bin_str(self.lrbuffer, str_value, str_size, enc, &error)
+		else:
+			result = lre_pack_str(self.lrbuffer, str_value, str_size, enc, &error)
+
+		if result != LRE_OK:
+			raise ValueError(lre_strerror(error).decode('utf8'))
+
+	cdef buffer_write_int(self, pyint, int fmt):
 		cdef lre_error_t error        = LRE_ERROR_NOTHING
 		cdef int         int_overflow = 0
 		cdef int64_t     int_value    = PyLong_AsLongLongAndOverflow(pyint, &int_overflow)
+		cdef int         result
 
 		if not int_overflow:
-			if lre_pack_int(self.lrbuffer, int_value, &error) != LRE_OK:
+			if fmt == FORMAT_DENSE:
+				result = lre_pack_dense_int(self.lrbuffer, int_value, &error)
+			elif fmt == FORMAT_BIN:
+				result = lre_pack_bin_int(self.lrbuffer, int_value, &error)
+			else:
+				result = lre_pack_int(self.lrbuffer, int_value, &error)
+
+			if result != LRE_OK:
 				raise ValueError(lre_strerror(error).decode('utf8'))
 			else:
 				return LRE_OK
 
-		cdef uint8_t *dst
-		cdef size_t   nbytes = (_PyLong_NumBits(pyint) + 7) >> 3
+		# Big integers have the regular format only
+		if fmt != FORMAT_TEXT:
+			raise OverflowError('big int out of range')
+
+		cdef size_t nbytes   = (_PyLong_NumBits(pyint) + 7) >> 3
+		cdef int    negative = pyint < 0
 
 		if nbytes > 65535:
 			raise OverflowError('big int out of range')
-	
-		# tag(1) + nbytes(4) + value(nbytes*2) + separator(1)
-		if lre_buffer_require(self.lrbuffer, (1+4+(nbytes*2)+1), &error) != LRE_OK:
-			raise MemoryError(lre_strerror(error).decode('utf8'))
-
-		dst = lre_buffer_end(self.lrbuffer)
 
-		if pyint < 0:
+		if negative:
 			pyint = -pyint
-			_PyLong_AsByteArray(<PyLongObject *> pyint, <unsigned char *> TMP65535, nbytes, 0, 0)
 
-			lrex_write_char  (&dst, LRE_TAG_NUMBER_NEGATIVE_BIG)
-			lrex_write_uint16(&dst, ~nbytes)
-			lrex_write_str   (&dst, TMP65535, nbytes, 0xff)
-			lrex_write_char  (&dst, LRE_SEP_NEGATIVE)
-		else:
-			_PyLong_AsByteArray(<PyLongObject *> pyint, <unsigned char *> TMP65535, nbytes, 0, 0)
+		_PyLong_AsByteArray(<PyLongObject *> pyint, <unsigned char *> TMP65535, nbytes, 0, 0)
 
-			lrex_write_char  (&dst, LRE_TAG_NUMBER_POSITIVE_BIG)
-			lrex_write_uint16(&dst, nbytes)
-			lrex_write_str   (&dst, TMP65535, nbytes, 0)
-			lrex_write_char  (&dst, LRE_SEP_POSITIVE)
-	
-		lre_buffer_set_size_distance(self.lrbuffer, dst)
+		if lre_pack_bigint(self.lrbuffer, TMP65535, nbytes, negative, &error) != LRE_OK:
+			raise ValueError(lre_strerror(error).decode('utf8'))
 
 	@staticmethod # Call by lre_tokenize()
 	cdef int callback_load_int(lre_loader_t *loader, int64_t value) except? LRE_FAIL:
@@ -172,12 +234,13 @@ cdef class LRE:
 	@staticmethod # Call by lre_tokenize()
 	cdef int callback_load_str(lre_loader_t *loader, lre_slice_t *slice, lre_enc_t enc) except? LRE_FAIL:
 		cdef LRE       self   = <LRE> loader.app_private
-		cdef ptrdiff_t nbytes = lre_slice_len(slice) >> 1
+		cdef size_t    nbytes = lre_slice_str_nbytes(slice, enc)
 		cdef bytes     s      = PyBytes_FromStringAndSize(NULL, nbytes)
 
-		lrex_read_str(&slice.src, <uint8_t *> (<char *> s), nbytes, 0)
+		if lre_slice_read_str(slice, <uint8_t *> (<char *> s), enc) != LRE_OK:
+			raise ValueError(lre_strerror(LRE_ERROR_CHAR).decode('utf8'))
 
-		if enc == LRE_ENC_UTF8:
+		if enc == LRE_ENC_UTF8 or enc == LRE_ENC_DENSE_UTF8 or enc == LRE_ENC_BIN_UTF8:
 			self.tmpkey.append(s.decode('utf8'))
 		else:
 			self.tmpkey.append(s)
@@ -186,23 +249,27 @@ cdef class LRE:
 
 	@staticmethod # Call by lre_tokenize()
 	cdef int callback_load_bigint(lre_loader_t *loader, const lre_metanumber_t *num) except? LRE_FAIL:
-		cdef LRE            self = <LRE> loader.app_private
-		cdef const uint8_t *src  = num.integral_data
-		cdef object         value
+		cdef LRE    self = <LRE> loader.app_private
+		cdef object value
 
 		if num.integral_nbytes > 65535:
 			raise OverflowError('big int out of range')
 
+		if lre_metanumber_read_integral(num, TMP65535, NULL) != LRE_OK:
+			raise ValueError(lre_strerror(LRE_ERROR_CHAR).decode('utf8'))
+
+		value = _PyLong_FromByteArray(<unsigned char *> TMP65535, num.integral_nbytes, 0, 0)
+
 		if num.negative_mask:
-			lrex_read_str(&src, TMP65535, num.integral_nbytes, 0xff)
-			value = _PyLong_FromByteArray(<unsigned char *> TMP65535, num.integral_nbytes, 0, 0)
 			value = -value
-		else:
-			lrex_read_str(&src, TMP65535, num.integral_nbytes, 0x00)
-			value = _PyLong_FromByteArray(<unsigned char *> TMP65535, num.integral_nbytes, 0, 0)
 
 		self.tmpkey.append(value)
 
 		return LRE_OK
 
+	@staticmethod # Call by lre_tokenize()
+	cdef int callback_load_decimal(lre_loader_t *loader, const lre_decimal_t *dec) except? LRE_FAIL:
+		cdef LRE self = <LRE> loader.app_private
 
+		self.tmpkey.append(Decimal((dec.negative != 0, tuple(map(int, str(dec.coefficient))), dec.exponent)))
+		return LRE_OK
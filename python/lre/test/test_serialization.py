@@ -1,10 +1,19 @@
 import unittest
+import random
+import struct
 import lre
+from decimal import Decimal
+from fractions import Fraction
 
 # Disable preallocated buffer
 newlre = lre.LRE(0)
 lre.dumps = newlre.pack
 lre.loads = newlre.load
+lre.dumps_dense = newlre.pack_dense
+lre.dumps_bin = newlre.pack_bin
+lre.loads_bin = newlre.load_bin
+
+compactlre = lre.LRE(0, compact=True)
 
 
 class TestOrder(unittest.TestCase):
@@ -100,16 +109,253 @@ class TestOrder(unittest.TestCase):
         l2 = sorted(l1, key=lre.dumps)
         self.assertEqual(l1, l2, 'invalid order')
 
+    def testDecimal(self):
+        self.assertEqual(lre.dumps(Decimal('10.5')), lre.dumps(10.5))
+        self.assertEqual(lre.dumps(Decimal('-3.000')), lre.dumps(-3))
+
+        l1 = [-1, -0.1, Decimal('-0.1'), 0, Decimal('0.1'), 0.1, Decimal('0.10000000000000001'), 1, Decimal('1e30')]
+        l2 = sorted(l1, key=lre.dumps)
+        self.assertEqual(l1, l2, 'invalid order')
+
+    def testDecimalScale(self):
+        l1 = [Decimal('-1e-19'), Decimal('-1e-20'), Decimal('1e-4900'), Decimal('1e-400'), Decimal('1E-20'), Decimal('1.0000000000000000001e-20'),
+              Decimal('1e-19'), Decimal('0.1234567890123456789'), Decimal('0.12345678901234567891')]
+        l2 = sorted(l1, key=lre.dumps)
+        self.assertEqual(l1, l2, 'invalid order')
+
+        # Fractions exact in binary are packed as floats at any scale
+        self.assertEqual(lre.dumps(Decimal('9.5367431640625E-7')), lre.dumps(2.0 ** -20))
+        self.assertEqual(lre.dumps(Decimal('7.450580596923828125E-9')), lre.dumps(2.0 ** -27))
+
+        with self.assertRaises(ValueError):
+            lre.dumps(Decimal('1e-4901'))
+
+    def testDecimalRandom(self):
+        rnd = random.Random(19)
+        l1 = []
+
+        for i in range(5000):
+            d = Decimal(rnd.randrange(1, 10 ** rnd.randint(1, 19))).scaleb(-rnd.randint(1, 400))
+            d = -d if i & 1 else d
+            l1.append(d)
+
+            # Rounded to odd, then correctly rounded to double
+            expected = int(d) if d == int(d) else float(d)
+            self.assertEqual(lre.loads(lre.dumps(d)), [expected], d)
+
+        l2 = sorted(l1, key=lre.dumps)
+        self.assertEqual(l2, sorted(l2), 'invalid order')
+
+    def testDecimalLarge(self):
+        # Integral decimals beyond 64-bit coefficient are integers
+        self.assertEqual(lre.dumps(Decimal('99999999999999999999')), lre.dumps(10 ** 20 - 1))
+        self.assertEqual(lre.dumps(Decimal('-123456789012345678901234567890.000')), lre.dumps(-123456789012345678901234567890))
+        self.assertEqual(lre.loads(lre.dumps(Decimal('99999999999999999999'))), [10 ** 20 - 1])
+
+        with self.assertRaises(ValueError):
+            lre.dumps(Decimal('9999999999999999999.9'))
+
+    def testDecimalSpecial(self):
+        self.assertEqual(lre.dumps(Decimal('Infinity')), lre.dumps(float('inf')))
+        self.assertEqual(lre.dumps(Decimal('-Infinity')), lre.dumps(float('-inf')))
+
+        with self.assertRaises(ValueError):
+            lre.dumps(Decimal('NaN'))
+
+    def testDecimalLoad(self):
+        decimallre = lre.LRE(0, decimal=True)
+        l1 = [Decimal('0.1'), Decimal('-3.25'), Decimal('0.123456789012345678'), 1, 'x']
+        l2 = decimallre.load(lre.dumps(l1))
+        self.assertEqual(l1, l2)
+        self.assertEqual([type(i) for i in l1], [type(i) for i in l2])
+
+        # Floats are exact decimals, if they have short ones
+        self.assertEqual(decimallre.load(lre.dumps([0.5, 0.1])), [Decimal('0.5'), 0.1])
+
+    def testDense(self):
+        self.assertEqual(lre.loads(b'n-?]+m-@ll1---------+xG3BYH3i,+'), [300, 1.5, 'hello'])
+        self.assertEqual(lre.loads(b'xl]*+'), [b'\xff'])
+
+        with self.assertRaises(ValueError):
+            lre.loads(b'xl]H+')
+
+    def testDenseSorting(self):
+        l1 = [float('-inf'), -2**63, -1e10, -300, -1.5, -1, -0.5, 0, 0.25, 1, 1.5, 255, 256, 2**63 - 1, 1e300, float('inf')]
+        l2 = sorted(l1, key=lre.dumps_dense)
+        self.assertEqual(l1, l2, 'invalid order')
+
+        l1 = [b'', b'\x00', b'\x00\x00', b'\x01', b'a', b'ab', b'b', b'\xff']
+        l2 = sorted(l1, key=lre.dumps_dense)
+        self.assertEqual(l1, l2, 'invalid order')
+
+    def testBinSorting(self):
+        l1 = [float('-inf'), -2**63, -1e10, -300, -1.5, -1, -0.5, 0, 0.25, 1, 1.5, 255, 256, 2**63 - 1, 1e300, float('inf')]
+        l2 = sorted(l1, key=lre.dumps_bin)
+        self.assertEqual(l1, l2, 'invalid order')
+
+        # Zero byte is escaped and still sorts below every other byte
+        l1 = [b'', b'\x00', b'\x00\x00', b'\x00\x01', b'\x01', b'a', b'a\x00', b'ab', b'\xff']
+        l2 = sorted(l1, key=lre.dumps_bin)
+        self.assertEqual(l1, l2, 'invalid order')
+
+        l1 = [[b'a', 2], [b'a\x00', 1], [b'ab', 0]]
+        l2 = sorted(l1, key=lre.dumps_bin)
+        self.assertEqual(l1, l2, 'invalid order')
+
+
+class TestRoundTrip(unittest.TestCase):
+    def testDense(self):
+        l1 = [0, -1, 1, -2**63, 2**63 - 1, 10.5, -0.1, 1e300, -1e-300, float('inf'), float('-inf'), b'\x00\xff', u'\u043a\u043b\u044e\u0447', b'']
+        self.assertEqual(lre.loads(lre.dumps_dense(l1)), l1)
+
+    def testBin(self):
+        l1 = [0, -1, 1, -2**63, 2**63 - 1, 10.5, -0.1, 1e300, -1e-300, float('inf'), float('-inf'), b'\x00\xff', u'\u043a\u043b\u044e\u0447', b'']
+        self.assertEqual(lre.loads_bin(lre.dumps_bin(l1)), l1)
+
+    def testBinEscape(self):
+        self.assertEqual(lre.dumps_bin(b'\x00'), b'X\x00\xff\x00h')
+        self.assertEqual(lre.loads_bin(b'X\x00\xff\x00\xffa\x00h'), [b'\x00\x00a'])
+
+        with self.assertRaises(ValueError):
+            lre.loads_bin(b'X\x00\x01\x00h')
+
+    def testBigint(self):
+        with self.assertRaises(OverflowError):
+            lre.dumps_dense(2**64)
+
+        with self.assertRaises(OverflowError):
+            lre.dumps_bin(-2**64)
+
+
+def hexkey(tag, data):
+    return tag + bytes(0x61 + (c >> 4 & 15 if i & 1 == 0 else c & 15) for c in data for i in (0, 1))
+
+
+def numkey(integral, exponent, fraction):
+    """Positive number key with fraction of any length, and its exact value"""
+    nbytes = max(1, (integral.bit_length() + 7) // 8)
+    data = integral.to_bytes(nbytes, 'big') + (exponent + 16383).to_bytes(2, 'big') + fraction
+    value = Fraction(integral)
+    f = int.from_bytes(fraction, 'big')
+
+    if f:
+        value += Fraction(f, 2 ** f.bit_length()) * Fraction(2) ** exponent
+
+    return hexkey(bytes([0x4c + nbytes]), data) + b'+', value
+
+
+class TestFloatDecode(unittest.TestCase):
+    def assertDecoded(self, integral, exponent, fraction):
+        key, value = numkey(integral, exponent, fraction)
+        self.assertEqual(lre.loads(key), [float(value)], key)
+
+    def testSubnormal(self):
+        l1 = [5e-324, -5e-324, 1e-320, 2.0 ** -1022, 2.225073858507201e-308, -2.225073858507201e-308, 4.9406564584124654e-310]
+        self.assertEqual(lre.loads(lre.dumps(l1)), l1)
+
+        # Half of the smallest subnormal is a tie to even zero, anything above rounds up
+        self.assertDecoded(0, -1074, b'\x80' + b'\x00' * 7)
+        self.assertDecoded(0, -1074, b'\x80' + b'\x00' * 7 + b'\x01')
+        self.assertDecoded(0, -1073, b'\xc0' + b'\x00' * 7)
+        self.assertEqual(lre.loads(numkey(0, -1074, b'\x80' + b'\x00' * 7)[0]), [0.0])
+
+    def testTies(self):
+        one = 1 << 63
+
+        # 53 bits are kept, the 54th is the halfway bit
+        for kept in [one >> 0, (one | 1 << 11), (one | 3 << 11)]:
+            tie = (kept | 1 << 10).to_bytes(8, 'big')
+            self.assertDecoded(0, 0, tie)
+            self.assertDecoded(0, 0, tie + b'\x00')
+            self.assertDecoded(0, 0, tie + b'\x00\x00\x01')
+            self.assertDecoded(5, -3, tie)
+            self.assertDecoded(5, -3, tie + b'\x00' * 7 + b'\x01')
+
+    def testCarry(self):
+        # Rounding up carries into the next binary exponent
+        self.assertDecoded(0, 0, b'\xff' * 8)
+        self.assertDecoded(0, -1022, b'\xff' * 8)
+        self.assertDecoded(0, -1023, b'\xff' * 9)
+        self.assertDecoded(1, 0, b'\xff' * 8)
+        self.assertDecoded(2 ** 53 - 1, 0, b'\x80')
+        self.assertDecoded(2 ** 53 - 1, 0, b'\x80\x00\x01')
+        self.assertDecoded(2 ** 64 - 1, 0, b'\x80')
+        self.assertEqual(lre.loads(numkey(0, 0, b'\xff' * 8)[0]), [1.0])
+
+    def testRandom(self):
+        rnd = random.Random(17)
+
+        for i in range(20000):
+            value = struct.unpack('<d', struct.pack('<Q', rnd.getrandbits(63)))[0]
+
+            if value != value or value in (float('inf'), float('-inf')):
+                continue
+
+            value = -value if i & 1 else value
+            expected = int(value) if value == int(value) else value
+            self.assertEqual(lre.loads(lre.dumps(value)), [expected])
+
+        for i in range(20000):
+            integral = rnd.getrandbits(rnd.randint(0, 64))
+            exponent = rnd.randint(-1100, 0) if integral == 0 else rnd.randint(-80, 0)
+            nbytes = rnd.randint(8, 12)
+            fraction = (rnd.getrandbits(8 * nbytes) | 1 << (8 * nbytes - 1)).to_bytes(nbytes, 'big')
+            self.assertDecoded(integral, exponent, fraction)
+
+
+class TestCompact(unittest.TestCase):
+    floats = [float('-inf'), -1e300, -2.0**64, -10.500000000000002, -10.5, -10.25, -10, -1.5, -1.0000000000000002,
+              -0.5, -5e-324, 0, 5e-324, 0.1, 0.5, 0.5000000000000001, 1, 10.25, 10.5, 10.500000000000002, 2.0**64, 1e300, float('inf')]
+
+    def testFormat(self):
+        self.assertEqual(compactlre.pack(10.5), b'Makdpppba+')
+        self.assertEqual(lre.dumps(10.5), b'Makdpppbaaaaaaaaaaaaa+')
+        self.assertEqual(compactlre.pack([1, 2.0, 'x']), lre.dumps([1, 2.0, 'x']))
+
+    def testRoundTrip(self):
+        self.assertEqual(compactlre.load(compactlre.pack(self.floats)), self.floats)
+        self.assertEqual(compactlre.load(compactlre.pack_dense(self.floats)), self.floats)
+
+    def testSorting(self):
+        l2 = sorted(self.floats, key=compactlre.pack)
+        self.assertEqual(self.floats, l2, 'invalid order')
+
+        l2 = sorted(self.floats, key=compactlre.pack_dense)
+        self.assertEqual(self.floats, l2, 'invalid order')
+
+        l1 = [[-0.5, 'b'], [-0.5, 'c'], [0.5, 'a'], [0.5000000000000001, 'a']]
+        l2 = sorted(l1, key=compactlre.pack)
+        self.assertEqual(l1, l2, 'invalid order')
+
+    def testDecimal(self):
+        with self.assertRaises(ValueError):
+            compactlre.pack(Decimal('10.5'))
+
 
 class TestLimits(unittest.TestCase):
     def testNan(self):
         with self.assertRaises(ValueError):
             lre.dumps(float('nan'))
 
+    def testFloatRange(self):
+        self.assertEqual(lre.loads(lre.dumps([float('-inf'), float('inf'), 1])), [float('-inf'), float('inf'), 1])
+        self.assertEqual(lre.loads(lre.dumps(1e300)), [int(1e300)])
+
+        l1 = [-1e300, -2.0**64, -2**63 - 1, -2.0**63, 2**63 - 1, 2.0**63, 2.0**64 + 4096, 1e300]
+        l2 = sorted(l1, key=lre.dumps)
+        self.assertEqual(l1, l2, 'invalid order')
+
     def testBigintOverflow(self):
         with self.assertRaises(OverflowError):
             lre.dumps(2**524280)
 
+    def testInvalidCharacter(self):
+        with self.assertRaises(ValueError):
+            lre.loads(b'XgbgzL+')
+
+        with self.assertRaises(ValueError):
+            lre.loads(b'X' + b'gb' * 40 + b'QbL+')
+
     def testDepthLimit(self):
         l = []
         l.append(l)
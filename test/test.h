@@ -0,0 +1,20 @@
+/*
+ * Minimal checks for C tests of lre.h.
+ * Every test is a standalone program, e.g.:
+ *   cc -std=c99 -pthread -I.. -o test_pool test_pool.c && ./test_pool
+ */
+#pragma once
+#ifndef _LRE_TEST_H
+#define _LRE_TEST_H
+
+#include <stdio.h>
+
+static int test_failures = 0;
+
+#define CHECK(x) \
+	((x) ? (void) 0 : (test_failures++, (void) fprintf(stderr, "%s:%i: check failed: %s\n", __FILE__, __LINE__, #x)))
+
+#define TEST_RESULT() \
+	(printf("%s: %s\n", __FILE__, test_failures ? "FAILED" : "OK"), test_failures != 0)
+
+#endif
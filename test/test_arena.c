@@ -0,0 +1,192 @@
+/*
+ * Arena: lre_arena_create(), lre_arena_buffer(), lre_arena_reset(), lre_arena_close().
+ *   cc -std=c99 -I.. -o test_arena test_arena.c -lm && ./test_arena
+ */
+#include "../lre.h"
+#include "test.h"
+
+
+#define NBUFS 3
+
+
+/* Backing allocator that counts arena and chunk allocations */
+static int nmalloc, nfree;
+
+
+static void *counting_malloc(void *ctx, size_t size) {
+	(void) ctx;
+	nmalloc++;
+	return malloc(size);
+}
+
+
+static void *counting_realloc(void *ctx, void *ptr, size_t size) {
+	(void) ctx;
+	return realloc(ptr, size);
+}
+
+
+static void counting_free(void *ctx, void *ptr) {
+	(void) ctx;
+	nfree += ptr != 0;
+	free(ptr);
+}
+
+
+static const lre_allocator_t counting = {
+	&counting_malloc,
+	&counting_realloc,
+	&counting_free,
+	0
+};
+
+
+/* The same fields into arena buffers and regular ones, interleaved */
+static void fill(lre_buffer_t **bufs, lre_buffer_t **refs, int rounds, int seed) {
+	uint8_t str[100];
+	int     i, b;
+
+	memset(str, 'a' + seed, sizeof(str));
+
+	for (i = 0; i < rounds; i++) {
+		for (b = 0; b < NBUFS; b++) {
+			int64_t value = (int64_t) i * 7919 * (b + 1) - seed;
+			size_t  len   = (size_t) (i * 13 + b) % sizeof(str);
+
+			CHECK(lre_pack_int(bufs[b], value, 0) == LRE_OK);
+			CHECK(lre_pack_str(bufs[b], str, len, LRE_ENC_RAW, 0) == LRE_OK);
+			lre_pack_int(refs[b], value, 0);
+			lre_pack_str(refs[b], str, len, LRE_ENC_RAW, 0);
+		}
+	}
+
+	for (b = 0; b < NBUFS; b++) {
+		CHECK(bufs[b]->size == refs[b]->size && memcmp(bufs[b]->data, refs[b]->data, refs[b]->size + 1) == 0);
+	}
+}
+
+
+static void test_interleaved(void) {
+	lre_arena_t  *arena;
+	lre_buffer_t *bufs[NBUFS];
+	lre_buffer_t *refs[NBUFS];
+	int           b, round, nchunks = 0;
+
+	nmalloc = nfree = 0;
+	arena = lre_arena_create(1024, &counting, 0);
+	CHECK(arena != 0);
+
+	for (round = 0; round < 3; round++) {
+		for (b = 0; b < NBUFS; b++) {
+			bufs[b] = lre_arena_buffer(arena, 16, 0);
+			refs[b] = lre_buffer_create(0, 0);
+			CHECK(bufs[b] != 0);
+		}
+
+		/* Buffers grow past chunk size while others allocate behind them */
+		fill(bufs, refs, 200, round);
+		CHECK(bufs[0]->capacity > 1024);
+
+		for (b = 0; b < NBUFS; b++) {
+			lre_buffer_close(refs[b]);
+		}
+
+		if (round == 0) {
+			nchunks = nmalloc;
+		}
+		else {
+			/* The same pattern reuses chunks of previous round */
+			CHECK(nmalloc == nchunks);
+		}
+
+		lre_arena_reset(arena);
+	}
+
+	lre_arena_close(arena);
+	CHECK(nmalloc == nfree);
+}
+
+
+static void test_in_place(void) {
+	lre_arena_t  *arena;
+	lre_buffer_t *buf;
+	uint8_t      *data;
+	void         *a, *b;
+
+	nmalloc = nfree = 0;
+	arena = lre_arena_create(4096, &counting, 0);
+	buf   = lre_arena_buffer(arena, 16, 0);
+	CHECK(nmalloc == 2);
+
+	/* Data of buffer is the last block, it grows without copy */
+	data = buf->data;
+	CHECK(lre_buffer_require(buf, 1000, 0) == LRE_OK);
+	CHECK(buf->data == data && buf->capacity >= 1000);
+	CHECK(lre_buffer_require(buf, 3000, 0) == LRE_OK);
+	CHECK(buf->data == data);
+
+	/* Past the chunk it moves to a new one */
+	lre_pack_int(buf, 12345, 0);
+	CHECK(lre_buffer_require(buf, 5000, 0) == LRE_OK);
+	CHECK(buf->data != data && nmalloc == 3);
+	CHECK(buf->size == 6 && memcmp(buf->data, "Ndadj+", 7) == 0);
+
+	/* Only the last block is released */
+	a = lre_arena_malloc(arena, 100);
+	lre_arena_free(arena, a);
+	b = lre_arena_malloc(arena, 100);
+	CHECK(a == b);
+
+	a = lre_arena_malloc(arena, 100);
+	lre_arena_free(arena, b);
+	CHECK(lre_arena_malloc(arena, 100) != b);
+
+	/* Block that is not the last is copied when it grows, kept when it shrinks */
+	memset(a, 'x', 100);
+	lre_arena_malloc(arena, 10);
+	CHECK(lre_arena_realloc(arena, a, 50) == a);
+	b = lre_arena_realloc(arena, a, 200);
+	CHECK(b != a && memcmp(b, a, 100) == 0);
+
+	lre_arena_close(arena);
+	CHECK(nmalloc == nfree);
+}
+
+
+static void test_replace_chunk(void) {
+	lre_arena_t *arena;
+	uint8_t     *block;
+
+	nmalloc = nfree = 0;
+	arena = lre_arena_create(256, &counting, 0);
+
+	/* Three small chunks, one per block */
+	CHECK(lre_arena_malloc(arena, 200) != 0);
+	CHECK(lre_arena_malloc(arena, 200) != 0);
+	CHECK(lre_arena_malloc(arena, 200) != 0);
+	CHECK(nmalloc == 1 + 3);
+
+	/* After reset the first chunk is reused, the second one is too small and replaced */
+	lre_arena_reset(arena);
+	CHECK(lre_arena_malloc(arena, 200) != 0);
+	CHECK(nmalloc == 1 + 3);
+
+	block = (uint8_t *) lre_arena_malloc(arena, 1000);
+	CHECK(block != 0 && nmalloc == 1 + 4 && nfree == 1);
+	memset(block, 0xab, 1000);
+
+	/* Replacement keeps following chunks: the third one is reused */
+	CHECK(lre_arena_malloc(arena, 200) != 0);
+	CHECK(nmalloc == 1 + 4);
+
+	lre_arena_close(arena);
+	CHECK(nmalloc == nfree);
+}
+
+
+int main(void) {
+	test_interleaved();
+	test_in_place();
+	test_replace_chunk();
+	return TEST_RESULT();
+}
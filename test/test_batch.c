@@ -0,0 +1,162 @@
+/*
+ * Batch tokenization: lre_tokenize_batch(), lre_tokenize_batch_mt().
+ *   cc -std=c99 -pthread -I.. -o test_batch test_batch.c -lm && ./test_batch
+ */
+#include "../lre.h"
+#include "test.h"
+
+
+#define NKEYS    5000
+#define NWORKERS 8
+
+
+typedef struct {
+	int64_t sum;
+	size_t  nkeys;
+	size_t  last;
+	int     ordered;
+} totals_t;
+
+
+static lre_buffer_t *buf;
+static lre_slice_t   keys[NKEYS];
+
+
+static int handler_int(lre_loader_t *loader, int64_t value) {
+	((totals_t *) loader->app_private)->sum += value;
+	return LRE_OK;
+}
+
+
+static int handler_key_end(lre_loader_t *loader, size_t index) {
+	totals_t *totals = (totals_t *) loader->app_private;
+
+	/* Indices are global and follow each other within a worker */
+	if (index != loader->key_index || (totals->nkeys && index != totals->last + 1)) {
+		totals->ordered = 0;
+	}
+
+	totals->last = index;
+	totals->nkeys++;
+	return LRE_OK;
+}
+
+
+static int handler_key_end_fail(lre_loader_t *loader, size_t index) {
+	(void) loader;
+	return index == 10 ? LRE_FAIL : LRE_OK;
+}
+
+
+static void init(lre_loader_t *loader, totals_t *totals) {
+	memset(totals, 0, sizeof(*totals));
+	totals->ordered = 1;
+	lre_loader_init(loader, totals);
+	loader->handler_int     = handler_int;
+	loader->handler_key_end = handler_key_end;
+}
+
+
+static void make_keys(void) {
+	size_t offsets[NKEYS + 1];
+	size_t i;
+
+	buf = lre_buffer_create(0, 0);
+
+	for (i = 0; i < NKEYS; i++) {
+		offsets[i] = buf->size;
+		lre_pack_int(buf, (int64_t) i, 0);
+		lre_pack_int(buf, -3, 0);
+	}
+
+	offsets[NKEYS] = buf->size;
+
+	/* Slices are taken once buffer is not reallocated anymore */
+	for (i = 0; i < NKEYS; i++) {
+		keys[i].src = buf->data + offsets[i];
+		keys[i].end = buf->data + offsets[i + 1];
+	}
+}
+
+
+static void test_batch(void) {
+	lre_loader_t loader;
+	totals_t     totals;
+	lre_error_t  error;
+
+	init(&loader, &totals);
+	CHECK(lre_tokenize_batch(&loader, keys, NKEYS, 0) == LRE_OK);
+	CHECK(totals.sum == (int64_t) NKEYS * (NKEYS - 1) / 2 - 3 * NKEYS);
+	CHECK(totals.nkeys == NKEYS && totals.ordered);
+
+	/* Failing handler stops at its key */
+	init(&loader, &totals);
+	loader.handler_key_end = handler_key_end_fail;
+	error = LRE_ERROR_NOTHING;
+	CHECK(lre_tokenize_batch(&loader, keys, NKEYS, &error) != LRE_OK);
+	CHECK(error == LRE_ERROR_HANDLER && loader.key_index == 10);
+
+	init(&loader, &totals);
+	CHECK(lre_tokenize_batch(&loader, keys, 0, 0) == LRE_OK && totals.nkeys == 0);
+}
+
+
+static void test_batch_mt(void) {
+	lre_loader_t loaders[NWORKERS];
+	totals_t     totals[NWORKERS];
+	lre_slice_t  broken[NKEYS];
+	lre_error_t  error;
+	int64_t      sum = 0;
+	size_t       nkeys = 0;
+	size_t       w;
+
+	for (w = 0; w < NWORKERS; w++) {
+		init(&loaders[w], &totals[w]);
+	}
+
+	CHECK(lre_tokenize_batch_mt(loaders, NWORKERS, keys, NKEYS, 0) == LRE_OK);
+
+	for (w = 0; w < NWORKERS; w++) {
+		CHECK(totals[w].ordered);
+		CHECK(totals[w].nkeys == NKEYS / NWORKERS);
+		sum   += totals[w].sum;
+		nkeys += totals[w].nkeys;
+	}
+
+	CHECK(nkeys == NKEYS);
+	CHECK(sum == (int64_t) NKEYS * (NKEYS - 1) / 2 - 3 * NKEYS);
+
+	/* Error in the middle is reported with key index of its worker */
+	memcpy(broken, keys, sizeof(broken));
+	broken[3001].src = (const uint8_t *) "Zab+";
+	broken[3001].end = broken[3001].src + 4;
+
+	for (w = 0; w < NWORKERS; w++) {
+		init(&loaders[w], &totals[w]);
+	}
+
+	error = LRE_ERROR_NOTHING;
+	CHECK(lre_tokenize_batch_mt(loaders, NWORKERS, broken, NKEYS, &error) != LRE_OK);
+	CHECK(error == LRE_ERROR_TAG);
+	CHECK(loaders[3001 / (NKEYS / NWORKERS)].key_index == 3001);
+
+	/* More workers than keys, bad number of workers */
+	for (w = 0; w < NWORKERS; w++) {
+		init(&loaders[w], &totals[w]);
+	}
+
+	CHECK(lre_tokenize_batch_mt(loaders, NWORKERS, keys, 3, 0) == LRE_OK);
+	CHECK(totals[0].nkeys + totals[1].nkeys + totals[2].nkeys == 3 && totals[3].nkeys == 0);
+
+	error = LRE_ERROR_NOTHING;
+	CHECK(lre_tokenize_batch_mt(loaders, 0, keys, NKEYS, &error) != LRE_OK && error == LRE_ERROR_RANGE);
+}
+
+
+int main(void) {
+	make_keys();
+	test_batch();
+	test_batch_mt();
+	lre_buffer_close(buf);
+	return TEST_RESULT();
+}
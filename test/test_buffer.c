@@ -0,0 +1,142 @@
+/*
+ * Buffer policy and allocators: lre_buffer_create_ex(), lre_buffer_set_policy(), lre_buffer_reset().
+ *   cc -std=c99 -I.. -o test_buffer test_buffer.c -lm && ./test_buffer
+ */
+#include "../lre.h"
+#include "test.h"
+
+
+typedef struct {
+	int nmalloc;
+	int nrealloc;
+	int nfree;
+} counts_t;
+
+
+static void *counting_malloc(void *ctx, size_t size) {
+	((counts_t *) ctx)->nmalloc++;
+	return malloc(size);
+}
+
+
+static void *counting_realloc(void *ctx, void *ptr, size_t size) {
+	((counts_t *) ctx)->nrealloc++;
+	return realloc(ptr, size);
+}
+
+
+static void counting_free(void *ctx, void *ptr) {
+	((counts_t *) ctx)->nfree += ptr != 0;
+	free(ptr);
+}
+
+
+/* Reallocations to pack n integers field by field */
+static int count_growth(unsigned growth, int n) {
+	counts_t        counts = {0, 0, 0};
+	lre_allocator_t allocator = {&counting_malloc, &counting_realloc, &counting_free, &counts};
+	lre_buffer_t   *buf = lre_buffer_create_ex(0, &allocator, 0);
+	int             i, nrealloc;
+
+	lre_buffer_set_policy(buf, growth, 0);
+	counts.nrealloc = 0;
+
+	for (i = 0; i < n; i++) {
+		CHECK(lre_pack_int(buf, (int64_t) i * 1000003, 0) == LRE_OK);
+		CHECK(buf->capacity > buf->size);
+	}
+
+	nrealloc = counts.nrealloc;
+	lre_buffer_close(buf);
+
+	/* Buffer struct and data */
+	CHECK(counts.nmalloc == 1 && counts.nfree == 2);
+	return nrealloc;
+}
+
+
+static void test_growth(void) {
+	int doubling = count_growth(200, 10000);
+	int exact    = count_growth(100, 10000);
+	int slow     = count_growth(110, 10000);
+
+	/* Geometric growth: logarithmic number of reallocations */
+	CHECK(doubling <= 16);
+	CHECK(slow > doubling && slow <= 100);
+
+	/* Exact growth reallocates on almost every field (slack of packers is 18 bytes) */
+	CHECK(exact >= 10000 / 4);
+
+	/* Growth below 100 is exact growth */
+	CHECK(count_growth(50, 1000) == count_growth(100, 1000));
+}
+
+
+static void test_shrink(void) {
+	counts_t        counts = {0, 0, 0};
+	lre_allocator_t allocator = {&counting_malloc, &counting_realloc, &counting_free, &counts};
+	lre_buffer_t   *buf = lre_buffer_create_ex(64, &allocator, 0);
+	uint8_t         big[1000];
+	int             i;
+
+	memset(big, 'x', sizeof(big));
+	lre_buffer_set_policy(buf, 200, 3);
+	CHECK(buf->reserved == 65 && buf->capacity == 65);
+
+	lre_pack_str(buf, big, sizeof(big), LRE_ENC_RAW, 0);
+	CHECK(buf->capacity > 2000);
+
+	/* Large reset keeps memory */
+	counts.nrealloc = 0;
+	CHECK(lre_buffer_reset(buf, 0) == LRE_OK);
+	CHECK(buf->capacity > 2000 && buf->size == 0 && counts.nrealloc == 0);
+
+	/* Small resets: shrink on the third one in a row */
+	for (i = 0; i < 2; i++) {
+		lre_pack_int(buf, i, 0);
+		CHECK(lre_buffer_reset(buf, 0) == LRE_OK);
+		CHECK(buf->capacity > 2000 && counts.nrealloc == 0);
+	}
+
+	/* Large one in between starts counting again */
+	lre_pack_str(buf, big, 100, LRE_ENC_RAW, 0);
+	CHECK(lre_buffer_reset(buf, 0) == LRE_OK);
+
+	for (i = 0; i < 2; i++) {
+		lre_pack_int(buf, i, 0);
+		CHECK(lre_buffer_reset(buf, 0) == LRE_OK);
+		CHECK(buf->capacity > 2000 && counts.nrealloc == 0);
+	}
+
+	lre_pack_int(buf, 1, 0);
+	CHECK(lre_buffer_reset(buf, 0) == LRE_OK);
+	CHECK(buf->capacity == buf->reserved && counts.nrealloc == 1);
+	CHECK(buf->size == 0 && buf->data[0] == 0);
+
+	/* Buffer at reserved capacity is never reallocated by reset */
+	for (i = 0; i < 10; i++) {
+		lre_pack_int(buf, i, 0);
+		CHECK(lre_buffer_reset(buf, 0) == LRE_OK);
+	}
+
+	CHECK(counts.nrealloc == 1);
+
+	/* Shrink on every reset */
+	lre_buffer_set_policy(buf, 200, 0);
+	lre_pack_str(buf, big, sizeof(big), LRE_ENC_RAW, 0);
+	lre_buffer_reset_fast(buf);
+	lre_pack_int(buf, 1, 0);
+	counts.nrealloc = 0;
+	CHECK(lre_buffer_reset(buf, 0) == LRE_OK);
+	CHECK(buf->capacity == buf->reserved && counts.nrealloc == 1);
+
+	lre_buffer_close(buf);
+	CHECK(counts.nmalloc == 1 && counts.nfree == 2);
+}
+
+
+int main(void) {
+	test_growth();
+	test_shrink();
+	return TEST_RESULT();
+}
@@ -0,0 +1,112 @@
+/*
+ * Single field extraction: lre_get_int(), lre_get_float(), lre_get_str_into().
+ *   cc -std=c99 -I.. -o test_get test_get.c -lm && ./test_get
+ */
+#include "../lre.h"
+#include "test.h"
+
+
+static void test_big_floats(void) {
+	static const double values[] = {0x1p+63, 1e20, -1e300, 1e308, -0x1.fffffffffffffp+63};
+	lre_buffer_t *buf = lre_buffer_create(0, 0);
+	uint8_t       huge[129];
+	double        f;
+	lre_error_t   error;
+	size_t        k;
+
+	/* Floats beyond 64-bit range are packed as BIG */
+	for (k = 0; k < sizeof(values) / sizeof(values[0]); k++) {
+		lre_pack_float(buf, values[k], 0);
+		lre_pack_dense_float(buf, values[k], 0);
+	}
+
+	for (k = 0; k < sizeof(values) / sizeof(values[0]); k++) {
+		f = 0;
+		CHECK(lre_get_float(buf->data, buf->size, k * 2, &f, 0) == LRE_OK && f == values[k]);
+		f = 0;
+		CHECK(lre_get_float(buf->data, buf->size, k * 2 + 1, &f, 0) == LRE_OK && f == values[k]);
+	}
+
+	/* Integer beyond double range */
+	memset(huge, 0xff, sizeof(huge));
+	lre_buffer_reset_fast(buf);
+	lre_pack_bigint(buf, huge, sizeof(huge), 1, 0);
+	error = LRE_ERROR_NOTHING;
+	CHECK(lre_get_float(buf->data, buf->size, 0, &f, &error) != LRE_OK && error == LRE_ERROR_RANGE);
+
+	lre_buffer_close(buf);
+}
+
+
+int main(void) {
+	lre_buffer_t *buf = lre_buffer_create(0, 0);
+	uint8_t       big[9] = {1, 0, 0, 0, 0, 0, 0, 0, 0};
+	int64_t       i;
+	double        f;
+	uint8_t       str[16];
+	size_t        len;
+	lre_enc_t     enc;
+	lre_error_t   error;
+
+	lre_pack_str(buf, (const uint8_t *) "user", 4, LRE_ENC_UTF8, 0);  /* 0 */
+	lre_pack_int(buf, -42, 0);                                        /* 1 */
+	lre_pack_float(buf, 0.25, 0);                                     /* 2 */
+	lre_pack_float(buf, 3.0, 0);                                      /* 3 */
+	lre_pack_bigint(buf, big, sizeof(big), 0, 0);                     /* 4 */
+	lre_pack_dense_str(buf, (const uint8_t *) "dense", 5, LRE_ENC_RAW, 0); /* 5 */
+	lre_pack_dense_int(buf, INT64_MIN, 0);                            /* 6 */
+
+	/* Integers, integral floats are integers too */
+	CHECK(lre_get_int(buf->data, buf->size, 1, &i, 0) == LRE_OK && i == -42);
+	CHECK(lre_get_int(buf->data, buf->size, 3, &i, 0) == LRE_OK && i == 3);
+	CHECK(lre_get_int(buf->data, buf->size, 6, &i, 0) == LRE_OK && i == INT64_MIN);
+
+	error = LRE_ERROR_NOTHING;
+	CHECK(lre_get_int(buf->data, buf->size, 2, &i, &error) != LRE_OK && error == LRE_ERROR_TYPE);
+
+	error = LRE_ERROR_NOTHING;
+	CHECK(lre_get_int(buf->data, buf->size, 0, &i, &error) != LRE_OK && error == LRE_ERROR_TYPE);
+
+	error = LRE_ERROR_NOTHING;
+	CHECK(lre_get_int(buf->data, buf->size, 4, &i, &error) != LRE_OK && error == LRE_ERROR_RANGE);
+
+	error = LRE_ERROR_NOTHING;
+	CHECK(lre_get_int(buf->data, buf->size, 7, &i, &error) != LRE_OK && error == LRE_ERROR_RANGE);
+
+	/* Floats, integers are converted */
+	CHECK(lre_get_float(buf->data, buf->size, 2, &f, 0) == LRE_OK && f == 0.25);
+	CHECK(lre_get_float(buf->data, buf->size, 1, &f, 0) == LRE_OK && f == -42.0);
+
+	CHECK(lre_get_float(buf->data, buf->size, 4, &f, 0) == LRE_OK && f == 0x1p+64);
+
+	error = LRE_ERROR_NOTHING;
+	CHECK(lre_get_float(buf->data, buf->size, 5, &f, &error) != LRE_OK && error == LRE_ERROR_TYPE);
+
+	/* Strings of both encodings */
+	len = sizeof(str);
+	CHECK(lre_get_str_into(buf->data, buf->size, 0, str, &len, &enc, 0) == LRE_OK);
+	CHECK(len == 4 && memcmp(str, "user", 4) == 0 && enc == LRE_ENC_UTF8);
+
+	len = sizeof(str);
+	CHECK(lre_get_str_into(buf->data, buf->size, 5, str, &len, &enc, 0) == LRE_OK);
+	CHECK(len == 5 && memcmp(str, "dense", 5) == 0 && enc == LRE_ENC_DENSE_RAW);
+
+	/* Small destination reports required size */
+	len = 2;
+	error = LRE_ERROR_NOTHING;
+	CHECK(lre_get_str_into(buf->data, buf->size, 0, str, &len, 0, &error) != LRE_OK);
+	CHECK(error == LRE_ERROR_ALLOCATION_SMALL && len == 4);
+
+	len = sizeof(str);
+	error = LRE_ERROR_NOTHING;
+	CHECK(lre_get_str_into(buf->data, buf->size, 1, str, &len, 0, &error) != LRE_OK && error == LRE_ERROR_TYPE);
+
+	/* Invalid character of string is reported */
+	len = sizeof(str);
+	error = LRE_ERROR_NOTHING;
+	CHECK(lre_get_str_into((const uint8_t *) "XgzH+", 5, 0, str, &len, 0, &error) != LRE_OK && error == LRE_ERROR_CHAR);
+
+	lre_buffer_close(buf);
+	test_big_floats();
+	return TEST_RESULT();
+}
@@ -0,0 +1,96 @@
+/*
+ * Field index: lre_index_fields().
+ *   cc -std=c99 -I.. -o test_index test_index.c -lm && ./test_index
+ */
+#include "../lre.h"
+#include "test.h"
+
+
+static void test_fields(void) {
+	lre_buffer_t *buf = lre_buffer_create(0, 0);
+	lre_slice_t   slices[8];
+	lre_reader_t  reader;
+	lre_field_t   field;
+	size_t        n;
+
+	lre_pack_int(buf, -5, 0);
+	lre_pack_str(buf, (const uint8_t *) "key", 3, LRE_ENC_RAW, 0);
+	lre_pack_float(buf, 2.5, 0);
+	lre_pack_dense_int(buf, 7, 0);
+
+	n = lre_index_fields(buf->data, buf->size, slices, 8);
+	CHECK(n == 4);
+
+	/* Slice spans from tag to separator */
+	CHECK(slices[0].src == buf->data && slices[0].src[0] == LRE_TAG_NUMBER_NEGATIVE_1);
+	CHECK(*slices[0].end == LRE_SEP_NEGATIVE);
+	CHECK(*slices[1].end == LRE_SEP_POSITIVE && slices[1].src == slices[0].end + 1);
+	CHECK(slices[3].end == buf->data + buf->size - 1);
+
+	lre_reader_init(&reader, slices[2].src, lre_slice_len(&slices[2]) + 1);
+	CHECK(lre_reader_next(&reader, &field, 0) == LRE_OK && field.as.f == 2.5);
+
+	lre_reader_init(&reader, slices[3].src, lre_slice_len(&slices[3]) + 1);
+	CHECK(lre_reader_next(&reader, &field, 0) == LRE_OK && field.as.i == 7);
+
+	/* Output is bounded by max */
+	CHECK(lre_index_fields(buf->data, buf->size, slices, 2) == 2);
+	CHECK(lre_index_fields(buf->data, buf->size, slices, 0) == 0);
+
+	/* Trailing data without separator is ignored */
+	CHECK(lre_index_fields(buf->data, buf->size - 1, slices, 8) == 3);
+	CHECK(lre_index_fields(buf->data, 0, slices, 8) == 0);
+
+	lre_buffer_close(buf);
+}
+
+
+static void test_blocks(void) {
+	lre_buffer_t *buf = lre_buffer_create(0, 0);
+	lre_slice_t   slices[400];
+	uint8_t       str[300];
+	size_t        i, n;
+
+	/* Keys longer than LRE_INDEX_BLOCK, fields cross block borders */
+	memset(str, 'x', sizeof(str));
+
+	for (i = 0; i < 200; i++) {
+		if (i % 50 == 0) {
+			lre_pack_str(buf, str, i + 1, LRE_ENC_RAW, 0);
+		}
+		else {
+			lre_pack_int(buf, (int64_t) i * 1000003, 0);
+		}
+	}
+
+	CHECK(buf->size > 2 * LRE_INDEX_BLOCK);
+
+	n = lre_index_fields(buf->data, buf->size, slices, 400);
+	CHECK(n == 200);
+
+	for (i = 0; i < n; i++) {
+		lre_reader_t reader;
+		lre_field_t  field;
+
+		CHECK(i == 0 || slices[i].src == slices[i - 1].end + 1);
+		lre_reader_init(&reader, slices[i].src, lre_slice_len(&slices[i]) + 1);
+		CHECK(lre_reader_next(&reader, &field, 0) == LRE_OK);
+		CHECK(lre_reader_done(&reader));
+
+		if (i % 50 == 0) {
+			CHECK(field.type == LRE_TYPE_STR && lre_slice_str_nbytes(&field.as.s.slice, field.as.s.enc) == i + 1);
+		}
+		else {
+			CHECK(field.type == LRE_TYPE_INT && field.as.i == (int64_t) i * 1000003);
+		}
+	}
+
+	lre_buffer_close(buf);
+}
+
+
+int main(void) {
+	test_fields();
+	test_blocks();
+	return TEST_RESULT();
+}
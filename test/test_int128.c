@@ -0,0 +1,224 @@
+/*
+ * 128-bit integers: lre_pack_int128(), lre_pack_uint128(), handler_int128.
+ *   cc -std=c99 -I.. -o test_int128 test_int128.c -lm && ./test_int128
+ */
+#include "../lre.h"
+#include "test.h"
+
+
+#if defined(LRE_INT128)
+
+#define INT128_MAX_ ((lre_int128_t) (((lre_uint128_t) 1 << 127) - 1))
+#define INT128_MIN_ (-INT128_MAX_ - 1)
+
+
+static lre_int128_t last_int128;
+static int64_t      last_int;
+static int          nint128, nint, nbigint;
+
+
+static int handler_int(lre_loader_t *loader, int64_t value) {
+	(void) loader;
+	last_int = value;
+	nint++;
+	return LRE_OK;
+}
+
+
+static int handler_int128(lre_loader_t *loader, lre_int128_t value) {
+	(void) loader;
+	last_int128 = value;
+	nint128++;
+	return LRE_OK;
+}
+
+
+static int handler_bigint(lre_loader_t *loader, const lre_metanumber_t *num) {
+	(void) loader;
+	(void) num;
+	nbigint++;
+	return LRE_OK;
+}
+
+
+/* Big-endian magnitude of value */
+static size_t magnitude_bytes(lre_uint128_t value, uint8_t *dst) {
+	uint8_t tmp[16];
+	size_t  n = 0;
+	size_t  i;
+
+	for (i = 0; i < 16; i++) {
+		tmp[15 - i] = (uint8_t) (value >> (i * 8));
+	}
+
+	for (i = 0; i < 16 && !tmp[i]; i++);
+
+	for (; i < 16; i++) {
+		dst[n++] = tmp[i];
+	}
+
+	return n;
+}
+
+
+static int compare_keys(const lre_buffer_t *a, const lre_buffer_t *b) {
+	size_t n = (a->size < b->size) ? a->size : b->size;
+	int    c = memcmp(a->data, b->data, n);
+
+	return c ? c : (a->size > b->size) - (a->size < b->size);
+}
+
+
+static void test_edges(void) {
+	static const lre_int128_t values[] = {
+		INT128_MIN_,
+		-((lre_int128_t) 1 << 64) - 1,
+		-((lre_int128_t) 1 << 64),
+		(lre_int128_t) INT64_MIN - 1,
+		INT64_MIN,
+		-1,
+		0,
+		INT64_MAX,
+		(lre_int128_t) INT64_MAX + 1,
+		((lre_int128_t) 1 << 64) - 1,
+		(lre_int128_t) 1 << 64,
+		INT128_MAX_
+	};
+	size_t        n = sizeof(values) / sizeof(values[0]);
+	lre_buffer_t *buf  = lre_buffer_create(0, 0);
+	lre_buffer_t *ref  = lre_buffer_create(0, 0);
+	lre_buffer_t *prev = lre_buffer_create(0, 0);
+	lre_buffer_t *swap;
+	lre_loader_t  loader;
+	size_t        i;
+
+	lre_loader_init(&loader, 0);
+	loader.handler_int    = handler_int;
+	loader.handler_int128 = handler_int128;
+	loader.handler_bigint = handler_bigint;
+
+	for (i = 0; i < n; i++) {
+		lre_int128_t value = values[i];
+
+		lre_buffer_reset_fast(buf);
+		lre_buffer_reset_fast(ref);
+		CHECK(lre_pack_int128(buf, value, 0) == LRE_OK);
+
+		/* Same encoding as lre_pack_int() and lre_pack_bigint() */
+		if (value >= INT64_MIN && value <= INT64_MAX) {
+			lre_pack_int(ref, (int64_t) value, 0);
+		}
+		else {
+			uint8_t mag[16];
+			size_t  nbytes = magnitude_bytes((value < 0) ? 0 - (lre_uint128_t) value : (lre_uint128_t) value, mag);
+
+			lre_pack_bigint(ref, mag, nbytes, value < 0, 0);
+		}
+
+		CHECK(buf->size == ref->size && memcmp(buf->data, ref->data, buf->size) == 0);
+
+		/* Ordered as values */
+		CHECK(i == 0 || compare_keys(prev, buf) < 0);
+
+		/* Back through handler_int128 or handler_int */
+		nint = nint128 = nbigint = 0;
+		CHECK(lre_tokenize(&loader, buf->data, buf->size, 0) == LRE_OK);
+
+		if (value >= INT64_MIN && value <= INT64_MAX) {
+			CHECK(nint == 1 && nint128 == 0 && last_int == (int64_t) value);
+		}
+		else {
+			CHECK(nint128 == 1 && nbigint == 0 && last_int128 == value);
+		}
+
+		/* Unsigned packer agrees on non-negative values */
+		if (value >= 0) {
+			lre_buffer_reset_fast(ref);
+			CHECK(lre_pack_uint128(ref, (lre_uint128_t) value, 0) == LRE_OK);
+			CHECK(buf->size == ref->size && memcmp(buf->data, ref->data, buf->size) == 0);
+		}
+
+		swap = prev;
+		prev = buf;
+		buf  = swap;
+	}
+
+	lre_buffer_close(buf);
+	lre_buffer_close(ref);
+	lre_buffer_close(prev);
+}
+
+
+static void test_beyond(void) {
+	lre_buffer_t *buf = lre_buffer_create(0, 0);
+	lre_buffer_t *max = lre_buffer_create(0, 0);
+	lre_loader_t  loader;
+	uint8_t       big[17];
+
+	lre_loader_init(&loader, 0);
+	loader.handler_int    = handler_int;
+	loader.handler_int128 = handler_int128;
+	loader.handler_bigint = handler_bigint;
+
+	/* Above INT128_MAX and below INT128_MIN: handler_bigint */
+	lre_pack_uint128(buf, ~(lre_uint128_t) 0, 0);
+	nint128 = nbigint = 0;
+	CHECK(lre_tokenize(&loader, buf->data, buf->size, 0) == LRE_OK && nbigint == 1 && nint128 == 0);
+
+	lre_pack_int128(max, INT128_MAX_, 0);
+	CHECK(compare_keys(max, buf) < 0);
+
+	memset(big, 0, sizeof(big));
+	big[0] = 0x80;
+	lre_buffer_reset_fast(buf);
+	lre_pack_bigint(buf, big, 16, 1, 0);
+	lre_buffer_reset_fast(max);
+	lre_pack_int128(max, INT128_MIN_, 0);
+	CHECK(compare_keys(buf, max) == 0);
+
+	big[15] = 1;
+	lre_buffer_reset_fast(buf);
+	lre_pack_bigint(buf, big, 16, 1, 0);
+	nint128 = nbigint = 0;
+	CHECK(lre_tokenize(&loader, buf->data, buf->size, 0) == LRE_OK && nbigint == 1 && nint128 == 0);
+	CHECK(compare_keys(buf, max) < 0);
+
+	/* More than 16 bytes: handler_bigint */
+	big[0] = 1;
+	lre_buffer_reset_fast(buf);
+	lre_pack_bigint(buf, big, 17, 0, 0);
+	nint128 = nbigint = 0;
+	CHECK(lre_tokenize(&loader, buf->data, buf->size, 0) == LRE_OK && nbigint == 1 && nint128 == 0);
+
+	/* Without handler_int128 everything BIG goes to handler_bigint */
+	loader.handler_int128 = 0;
+	lre_buffer_reset_fast(buf);
+	lre_pack_int128(buf, (lre_int128_t) 1 << 64, 0);
+	nint128 = nbigint = 0;
+	CHECK(lre_tokenize(&loader, buf->data, buf->size, 0) == LRE_OK && nbigint == 1 && nint128 == 0);
+
+	lre_buffer_close(buf);
+	lre_buffer_close(max);
+}
+
+
+int main(void) {
+	test_edges();
+	test_beyond();
+	return TEST_RESULT();
+}
+
+#else
+
+int main(void) {
+	lre_loader_t loader;
+
+	/* Member exists without LRE_INT128, it is just never called */
+	lre_loader_init(&loader, 0);
+	CHECK(loader.handler_int128 == 0);
+
+	printf("%s: skipped, no LRE_INT128\n", __FILE__);
+	return TEST_RESULT();
+}
+
+#endif
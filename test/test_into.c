@@ -0,0 +1,228 @@
+/*
+ * Packing into caller memory: lre_packed_size_*(), lre_pack_*_into(). Also lre_pack_row().
+ * Destinations are allocated with exact size, run with -fsanitize=address.
+ *   cc -std=c99 -I.. -o test_into test_into.c -lm && ./test_into
+ */
+#include "../lre.h"
+#include "test.h"
+
+#include <float.h>
+
+
+static lre_buffer_t *buf;
+
+
+/* Exact size, the same bytes as buffer packer, nothing written if capacity is short */
+static void check_into(size_t size, size_t slack, size_t (*into)(uint8_t *, size_t, const void *, lre_error_t *), const void *arg) {
+	uint8_t    *dst = (uint8_t *) malloc((size + slack) ? size + slack : 1);
+	lre_error_t error;
+	size_t      i;
+
+	CHECK(size == buf->size);
+	CHECK(into(dst, size + slack, arg, 0) == size);
+	CHECK(memcmp(dst, buf->data, size) == 0);
+
+	if (size && !slack) {
+		memset(dst, 0xee, size);
+		error = LRE_ERROR_NOTHING;
+		CHECK(into(dst, size - 1, arg, &error) == 0 && error == LRE_ERROR_ALLOCATION_SMALL);
+
+		for (i = 0; i < size && dst[i] == 0xee; i++);
+		CHECK(i == size);
+	}
+
+	free(dst);
+}
+
+
+static size_t into_int(uint8_t *dst, size_t cap, const void *arg, lre_error_t *error) {
+	return lre_pack_int_into(dst, cap, *(const int64_t *) arg, error);
+}
+
+
+static size_t into_float(uint8_t *dst, size_t cap, const void *arg, lre_error_t *error) {
+	return lre_pack_float_into(dst, cap, *(const double *) arg, error);
+}
+
+
+static size_t into_str(uint8_t *dst, size_t cap, const void *arg, lre_error_t *error) {
+	const lre_value_t *value = (const lre_value_t *) arg;
+	return lre_pack_str_into(dst, cap, value->as.s.src, value->as.s.len, value->as.s.enc, error);
+}
+
+
+typedef struct {
+	const lre_value_t *fields;
+	size_t             n;
+} row_t;
+
+
+static size_t into_row(uint8_t *dst, size_t cap, const void *arg, lre_error_t *error) {
+	const row_t *row = (const row_t *) arg;
+	return lre_pack_row_into(dst, cap, row->fields, row->n, error);
+}
+
+
+static void test_int(void) {
+	int64_t value;
+	int     shift;
+
+	/* Every length of integer, cap < 1+16+1 takes exact writer */
+	for (shift = 0; shift < 64; shift++) {
+		int64_t values[4];
+		int     k;
+
+		values[0] = (int64_t) (UINT64_C(1) << shift);
+		values[1] = (int64_t) ((UINT64_C(1) << shift) - 1);
+		values[2] = (int64_t) (0 - (uint64_t) values[0]);
+		values[3] = -values[1] - 1;
+
+		for (k = 0; k < 4; k++) {
+			lre_buffer_reset_fast(buf);
+			lre_pack_int(buf, values[k], 0);
+			check_into(lre_packed_size_int(values[k]), 0, into_int, &values[k]);
+		}
+	}
+
+	value = INT64_MAX;
+	lre_buffer_reset_fast(buf);
+	lre_pack_int(buf, value, 0);
+	check_into(lre_packed_size_int(value), 0, into_int, &value);
+}
+
+
+static void test_float(void) {
+	static const double values[] = {
+		0.0, 0.5, -10.5, 1.0 / 3, 1e-300, -5e-324, 123456.789, 0x1p+62,
+		0x1p+63, -1e20, 1e300, DBL_MAX, -DBL_MAX, INFINITY, -INFINITY
+	};
+	lre_error_t error;
+	uint8_t     dst[300];
+	double      nan = NAN;
+	size_t      i;
+
+	for (i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+		lre_buffer_reset_fast(buf);
+		lre_pack_float(buf, values[i], 0);
+		check_into(lre_packed_size_float(values[i]), 0, into_float, &values[i]);
+	}
+
+	/* BIG integral part of DBL_MAX is 128 bytes */
+	CHECK(lre_packed_size_float(DBL_MAX) == 1 + 4 + 256 + 1);
+
+	error = LRE_ERROR_NOTHING;
+	CHECK(lre_packed_size_float(nan) == 0);
+	CHECK(lre_pack_float_into(dst, sizeof(dst), nan, &error) == 0 && error == LRE_ERROR_NAN);
+}
+
+
+static void test_str(void) {
+	uint8_t src[64];
+	size_t  len;
+
+	for (len = 0; len < sizeof(src); len++) {
+		src[len] = (uint8_t) (len * 37);
+	}
+
+	for (len = 0; len <= sizeof(src); len++) {
+		lre_value_t value = lre_value_str(src, len, (len & 1) ? LRE_ENC_UTF8 : LRE_ENC_RAW);
+
+		lre_buffer_reset_fast(buf);
+		lre_pack_str(buf, src, len, value.as.s.enc, 0);
+		CHECK(lre_packed_size_str(len) == buf->size);
+		check_into(lre_packed_size_str(len), 0, into_str, &value);
+	}
+}
+
+
+static void test_row(void) {
+	lre_value_t fields[5];
+	row_t       row;
+	lre_error_t error;
+	uint8_t     dst[100];
+	size_t      size;
+
+	fields[0] = lre_value_int(-1);
+	fields[1] = lre_value_str((const uint8_t *) "abc", 3, LRE_ENC_UTF8);
+	fields[2] = lre_value_float(2.25);
+	fields[3] = lre_value_int(INT64_MIN);
+	fields[4] = lre_value_int(7);
+	row.fields = fields;
+
+	/* Exactly sized and with slack, integer last */
+	for (row.n = 0; row.n <= 5; row.n++) {
+		lre_buffer_reset_fast(buf);
+		CHECK(lre_pack_row(buf, fields, row.n, 0) == LRE_OK);
+
+		size = lre_packed_size_row(fields, row.n, 0);
+		check_into(size, 0, into_row, &row);
+		check_into(size, LRE_PACK_SLACK, into_row, &row);
+	}
+
+	/* Invalid field: no size, nothing written */
+	fields[2] = lre_value_float(NAN);
+	memset(dst, 0xee, sizeof(dst));
+	error = LRE_ERROR_NOTHING;
+	CHECK(lre_packed_size_row(fields, 5, &error) == 0 && error == LRE_ERROR_NAN);
+	error = LRE_ERROR_NOTHING;
+	CHECK(lre_pack_row_into(dst, sizeof(dst), fields, 5, &error) == 0 && error == LRE_ERROR_NAN);
+	CHECK(dst[0] == 0xee);
+}
+
+
+static void test_pack_row(void) {
+	lre_buffer_t *ref = lre_buffer_create(0, 0);
+	lre_value_t   fields[6];
+	lre_error_t   error;
+	size_t        size;
+
+	fields[0] = lre_value_str((const uint8_t *) "user", 4, LRE_ENC_UTF8);
+	fields[1] = lre_value_int(INT64_MIN);
+	fields[2] = lre_value_float(-0.75);
+	fields[3] = lre_value_float(1e20);
+	fields[4] = lre_value_str((const uint8_t *) "", 0, LRE_ENC_RAW);
+	fields[5] = lre_value_int(300);
+
+	/* Appended to existing content, the same as field by field */
+	lre_buffer_reset_fast(buf);
+	lre_pack_int(buf, 1, 0);
+	lre_pack_int(ref, 1, 0);
+	CHECK(lre_pack_row(buf, fields, 6, 0) == LRE_OK);
+
+	lre_pack_str(ref, (const uint8_t *) "user", 4, LRE_ENC_UTF8, 0);
+	lre_pack_int(ref, INT64_MIN, 0);
+	lre_pack_float(ref, -0.75, 0);
+	lre_pack_float(ref, 1e20, 0);
+	lre_pack_str(ref, (const uint8_t *) "", 0, LRE_ENC_RAW, 0);
+	lre_pack_int(ref, 300, 0);
+
+	CHECK(buf->size == ref->size && memcmp(buf->data, ref->data, ref->size + 1) == 0);
+
+	/* Invalid field in the middle: buffer is untouched */
+	size = buf->size;
+	fields[3] = lre_value_float(NAN);
+	error = LRE_ERROR_NOTHING;
+	CHECK(lre_pack_row(buf, fields, 6, &error) != LRE_OK && error == LRE_ERROR_NAN);
+	CHECK(buf->size == size && buf->data[size] == 0);
+
+	fields[3].type = (lre_type_t) 77;
+	error = LRE_ERROR_NOTHING;
+	CHECK(lre_pack_row(buf, fields, 6, &error) != LRE_OK && error == LRE_ERROR_TYPE);
+	CHECK(buf->size == size);
+
+	lre_buffer_close(ref);
+}
+
+
+int main(void) {
+	buf = lre_buffer_create(0, 0);
+
+	test_int();
+	test_float();
+	test_str();
+	test_row();
+	test_pack_row();
+
+	lre_buffer_close(buf);
+	return TEST_RESULT();
+}
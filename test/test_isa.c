@@ -0,0 +1,150 @@
+/*
+ * Kernels of every supported instruction set produce the same results: lre_set_isa().
+ *   cc -std=c99 -I.. -o test_isa test_isa.c -lm && ./test_isa
+ */
+#include "../lre.h"
+#include "test.h"
+
+
+#define MAX_LEN    300
+#define MAX_OFFSET 5
+
+
+static uint8_t input[MAX_LEN + MAX_OFFSET];
+
+
+/* Copy of key at misaligned address */
+static const uint8_t *misalign(uint8_t *space, const lre_buffer_t *key, size_t offset) {
+	memcpy(space + offset, key->data, key->size);
+	return space + offset;
+}
+
+
+static void log_bytes(lre_buffer_t *log, const void *src, size_t len) {
+	lre_buffer_require(log, len, 0);
+	memcpy(lre_buffer_end(log), src, len);
+	log->size += len;
+}
+
+
+static void log_size(lre_buffer_t *log, size_t value) {
+	log_bytes(log, &value, sizeof(value));
+}
+
+
+/* Everything kernels are used for, appended to log */
+static void run(lre_buffer_t *log) {
+	static uint8_t space[4 * MAX_LEN + 64 + MAX_OFFSET];
+	lre_buffer_t  *key = lre_buffer_create(0, 0);
+	uint8_t        str[MAX_LEN];
+	lre_slice_t    slices[8];
+	size_t         len, offset;
+
+	for (len = 0; len <= MAX_LEN; len++) {
+		for (offset = 0; offset < MAX_OFFSET; offset++) {
+			const uint8_t *src;
+			lre_error_t    error;
+			size_t         n, i, bad;
+
+			/* Packing from misaligned source */
+			lre_buffer_reset_fast(key);
+			lre_pack_int(key, (int64_t) len, 0);
+			lre_pack_str(key, input + offset, len, LRE_ENC_RAW, 0);
+			lre_pack_dense_str(key, input + offset, len, LRE_ENC_UTF8, 0);
+			lre_pack_int(key, -(int64_t) offset, 0);
+			log_size(log, key->size);
+			log_bytes(log, key->data, key->size);
+
+			src = misalign(space, key, offset);
+
+			/* Decoding, index, validation */
+			n = sizeof(str);
+			error = LRE_ERROR_NOTHING;
+			log_size(log, lre_get_str_into(src, key->size, 1, str, &n, 0, &error));
+			log_size(log, n);
+			log_bytes(log, str, n);
+
+			n = sizeof(str);
+			log_size(log, lre_get_str_into(src, key->size, 2, str, &n, 0, &error));
+			log_size(log, n);
+			log_bytes(log, str, n);
+
+			n = lre_index_fields(src, key->size, slices, 8);
+			log_size(log, n);
+
+			for (i = 0; i < n; i++) {
+				log_size(log, slices[i].src - src);
+				log_size(log, slices[i].end - src);
+			}
+
+			error = LRE_ERROR_NOTHING;
+			i = 0;
+			log_size(log, lre_validate(src, key->size, &error, &i));
+			log_size(log, error);
+			log_size(log, i);
+
+			/* Bad character somewhere in the middle, also a separator */
+			if (key->size < 8) {
+				continue;
+			}
+
+			bad = 3 + (len * 7 + offset) % (key->size - 6);
+			src = misalign(space, key, offset);
+			space[offset + bad] = (len & 1) ? 'z' : LRE_SEP_POSITIVE;
+
+			n = sizeof(str);
+			error = LRE_ERROR_NOTHING;
+			log_size(log, lre_get_str_into(src, key->size, 1, str, &n, 0, &error));
+			log_size(log, error);
+
+			n = lre_index_fields(src, key->size, slices, 8);
+			log_size(log, n);
+
+			for (i = 0; i < n; i++) {
+				log_size(log, slices[i].end - src);
+			}
+
+			error = LRE_ERROR_NOTHING;
+			i = 0;
+			log_size(log, lre_validate(src, key->size, &error, &i));
+			log_size(log, error);
+			log_size(log, i);
+		}
+	}
+
+	lre_buffer_close(key);
+}
+
+
+int main(void) {
+	static const lre_isa_t isas[] = {LRE_ISA_SSE2, LRE_ISA_AVX2, LRE_ISA_NEON};
+	lre_buffer_t *expected = lre_buffer_create(0, 0);
+	lre_buffer_t *log      = lre_buffer_create(0, 0);
+	uint32_t      seed     = 12345;
+	size_t        i;
+
+	for (i = 0; i < sizeof(input); i++) {
+		seed = seed * 1103515245 + 12345;
+		input[i] = (uint8_t) (seed >> 16);
+	}
+
+	/* Scalar kernels are the reference */
+	CHECK(lre_set_isa(LRE_ISA_SCALAR, 0) == LRE_OK && lre_get_isa() == LRE_ISA_SCALAR);
+	run(expected);
+
+	for (i = 0; i < sizeof(isas) / sizeof(isas[0]); i++) {
+		if (lre_set_isa(isas[i], 0) != LRE_OK) {
+			printf("%s: isa %i is not supported\n", __FILE__, (int) isas[i]);
+			continue;
+		}
+
+		CHECK(lre_get_isa() == isas[i]);
+		lre_buffer_reset_fast(log);
+		run(log);
+		CHECK(log->size == expected->size && memcmp(log->data, expected->data, log->size) == 0);
+	}
+
+	lre_buffer_close(expected);
+	lre_buffer_close(log);
+	return TEST_RESULT();
+}
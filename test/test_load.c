@@ -0,0 +1,113 @@
+/*
+ * Loading with lre_tokenize(): floats beyond 64-bit range and default handlers.
+ *   cc -std=c99 -I.. -o test_load test_load.c -lm && ./test_load
+ */
+#include "../lre.h"
+#include "test.h"
+
+#include <float.h>
+
+
+static double loaded;
+static int    nbigint;
+
+
+static int handler_float(lre_loader_t *loader, double value) {
+	(void) loader;
+	loaded = value;
+	return LRE_OK;
+}
+
+
+static int handler_bigint(lre_loader_t *loader, const lre_metanumber_t *num) {
+	(void) loader;
+	(void) num;
+	nbigint++;
+	return LRE_OK;
+}
+
+
+static void test_big_floats(void) {
+	/* -2^63 is INT64_MIN, not BIG */
+	static const double values[] = {
+		0x1p+63, -0x1.0000000000001p+63, 0x1p+64, -0x1p+64,
+		1e20, -1e20, 1e300, -1e300, DBL_MAX, -DBL_MAX, 0x1.fffffffffffffp+63
+	};
+	lre_buffer_t *buf = lre_buffer_create(0, 0);
+	lre_loader_t  loader;
+	size_t        i;
+
+	lre_loader_init(&loader, 0);
+	loader.handler_float = handler_float;
+
+	for (i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+		lre_buffer_reset_fast(buf);
+		CHECK(lre_pack_float(buf, values[i], 0) == LRE_OK);
+
+		/* Default handler_bigint passes value to handler_float */
+		loaded = 0;
+		CHECK(lre_tokenize(&loader, buf->data, buf->size, 0) == LRE_OK);
+		CHECK(loaded == values[i]);
+
+		lre_buffer_reset_fast(buf);
+		CHECK(lre_pack_dense_float(buf, values[i], 0) == LRE_OK);
+		loaded = 0;
+		CHECK(lre_tokenize(&loader, buf->data, buf->size, 0) == LRE_OK);
+		CHECK(loaded == values[i]);
+	}
+
+	/* Custom handler_bigint still gets them */
+	loader.handler_bigint = handler_bigint;
+	lre_buffer_reset_fast(buf);
+	lre_pack_float(buf, 1e20, 0);
+	CHECK(lre_tokenize(&loader, buf->data, buf->size, 0) == LRE_OK && nbigint == 1);
+
+	lre_buffer_close(buf);
+}
+
+
+static void test_big_ints(void) {
+	lre_buffer_t *buf = lre_buffer_create(0, 0);
+	lre_loader_t  loader;
+	uint8_t       big[129];
+	lre_error_t   error;
+
+	lre_loader_init(&loader, 0);
+	loader.handler_float = handler_float;
+
+	/* Rounded to nearest even: 2^64 + 2^11 + 1 is above halfway */
+	memset(big, 0, sizeof(big));
+	big[0] = 1;
+	big[7] = 0x08;
+	big[8] = 0x01;
+	lre_pack_bigint(buf, big, 9, 0, 0);
+	CHECK(lre_tokenize(&loader, buf->data, buf->size, 0) == LRE_OK);
+	CHECK(loaded == 0x1.0000000000001p+64);
+
+	/* Exactly halfway rounds down to even */
+	lre_buffer_reset_fast(buf);
+	big[8] = 0;
+	lre_pack_bigint(buf, big, 9, 1, 0);
+	CHECK(lre_tokenize(&loader, buf->data, buf->size, 0) == LRE_OK);
+	CHECK(loaded == -0x1p+64);
+
+	/* Beyond double range */
+	lre_buffer_reset_fast(buf);
+	memset(big, 0xff, sizeof(big));
+	lre_pack_bigint(buf, big, 128, 0, 0);
+	error = LRE_ERROR_NOTHING;
+	CHECK(lre_tokenize(&loader, buf->data, buf->size, &error) != LRE_OK && error == LRE_ERROR_HANDLER);
+
+	lre_buffer_reset_fast(buf);
+	lre_pack_bigint(buf, big, 129, 0, 0);
+	CHECK(lre_tokenize(&loader, buf->data, buf->size, 0) != LRE_OK);
+
+	lre_buffer_close(buf);
+}
+
+
+int main(void) {
+	test_big_floats();
+	test_big_ints();
+	return TEST_RESULT();
+}
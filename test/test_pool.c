@@ -0,0 +1,176 @@
+/*
+ * Buffer pool: acquire/release/flush from several threads.
+ *   cc -std=c99 -pthread -I.. -o test_pool test_pool.c && ./test_pool
+ */
+#include "../lre.h"
+#include "test.h"
+
+#include <pthread.h>
+
+
+#define NTHREADS 8
+#define NROUNDS  20000
+
+
+static lre_buffer_pool_t *pools[2];
+
+
+static void *worker(void *arg) {
+	size_t id = (size_t) arg;
+	int    i;
+
+	for (i = 0; i < NROUNDS; i++) {
+		/* Alternate pools and sizes, keep two buffers at once */
+		lre_buffer_pool_t *pool = pools[i & 1];
+		size_t             size = 16 + (size_t) ((i * 7 + id) % 500);
+		lre_buffer_t      *a    = lre_buffer_pool_acquire(pool, size, 0);
+		lre_buffer_t      *b    = lre_buffer_pool_acquire(pool, size / 2, 0);
+
+		CHECK(a && b && a != b);
+
+		if (!a || !b) {
+			break;
+		}
+
+		CHECK(a->capacity > size && a->size == 0);
+		memset(a->data, (int) id, size);
+		memset(b->data, (int) ~id, size / 2);
+		CHECK(a->data[size - 1] == (uint8_t) id);
+
+		lre_buffer_pool_release(pool, b);
+		lre_buffer_pool_release(pool, a);
+
+		/* Sometimes give buffers to other threads */
+		if (i % 1000 == 999) {
+			lre_buffer_pool_flush(pool);
+		}
+	}
+
+	lre_buffer_pool_flush(pools[0]);
+	lre_buffer_pool_flush(pools[1]);
+	return 0;
+}
+
+
+static void test_threads(void) {
+	pthread_t threads[NTHREADS];
+	lre_buffer_pool_stats_t stats[2];
+	size_t i;
+
+	pools[0] = lre_buffer_pool_create(0, 0);
+	pools[1] = lre_buffer_pool_create(0, 0);
+	CHECK(pools[0] && pools[1] && pools[0]->id != pools[1]->id);
+
+	for (i = 0; i < NTHREADS; i++) {
+		CHECK(pthread_create(&threads[i], 0, worker, (void *) i) == 0);
+	}
+
+	for (i = 0; i < NTHREADS; i++) {
+		pthread_join(threads[i], 0);
+	}
+
+	lre_buffer_pool_stats(pools[0], &stats[0]);
+	lre_buffer_pool_stats(pools[1], &stats[1]);
+
+	/* Every acquire is counted once flushed */
+	CHECK(stats[0].hits + stats[0].misses + stats[1].hits + stats[1].misses == (size_t) NTHREADS * NROUNDS * 2);
+
+	/* Switching pools does not drop thread caches */
+	CHECK(stats[0].misses + stats[1].misses < (size_t) NTHREADS * 2 * LRE_POOL_BUCKETS * 4);
+
+	lre_buffer_pool_close(pools[0]);
+	lre_buffer_pool_close(pools[1]);
+}
+
+
+static void test_many_pools(void) {
+	lre_buffer_pool_t *many[LRE_POOL_THREAD_CACHES + 2];
+	lre_buffer_pool_stats_t stats;
+	int i, round;
+
+	for (i = 0; i < LRE_POOL_THREAD_CACHES + 2; i++) {
+		many[i] = lre_buffer_pool_create(0, 0);
+	}
+
+	/* More pools than thread caches: evicted caches are flushed, not lost */
+	for (round = 0; round < 100; round++) {
+		for (i = 0; i < LRE_POOL_THREAD_CACHES + 2; i++) {
+			lre_buffer_pool_release(many[i], lre_buffer_pool_acquire(many[i], 100, 0));
+		}
+	}
+
+	for (i = 0; i < LRE_POOL_THREAD_CACHES + 2; i++) {
+		lre_buffer_pool_flush(many[i]);
+		lre_buffer_pool_stats(many[i], &stats);
+		CHECK(stats.hits + stats.misses == 100);
+		CHECK(stats.misses == 1);
+	}
+
+	for (i = 0; i < LRE_POOL_THREAD_CACHES + 2; i++) {
+		lre_buffer_pool_close(many[i]);
+	}
+}
+
+
+static void test_reuse_address(void) {
+	lre_buffer_pool_t *pool = lre_buffer_pool_create(0, 0);
+	lre_buffer_pool_stats_t stats;
+	size_t id = pool->id;
+
+	lre_buffer_pool_release(pool, lre_buffer_pool_acquire(pool, 10, 0));
+
+	/* Pool with the same address but another id does not see cached buffers */
+	pool->id = id + 1000;
+	lre_buffer_pool_release(pool, lre_buffer_pool_acquire(pool, 10, 0));
+	CHECK(pool->all && pool->all->all_next);
+	lre_buffer_pool_flush(pool);
+
+	pool->id = id;
+	lre_buffer_pool_flush(pool);
+
+	lre_buffer_pool_stats(pool, &stats);
+	CHECK(stats.hits == 0 && stats.misses == 2);
+	lre_buffer_pool_close(pool);
+}
+
+
+static void test_bounded_refill(void) {
+	lre_buffer_pool_t *pool = lre_buffer_pool_create(0, 0);
+	lre_buffer_t      *bufs[LRE_POOL_CACHE * 3];
+	lrex_pool_cache_t *cache;
+	int i, n = 0;
+	lre_pool_node_t *it;
+
+	for (i = 0; i < LRE_POOL_CACHE * 3; i++) {
+		bufs[i] = lre_buffer_pool_acquire(pool, 10, 0);
+	}
+
+	for (i = 0; i < LRE_POOL_CACHE * 3; i++) {
+		lre_buffer_pool_release(pool, bufs[i]);
+	}
+
+	lre_buffer_pool_flush(pool);
+	lre_buffer_pool_release(pool, lre_buffer_pool_acquire(pool, 10, 0));
+
+	/* Thread takes at most LRE_POOL_CACHE buffers, others stay global */
+	cache = lrex_pool_cache_find(pool);
+	CHECK(cache && cache->count[0] <= LRE_POOL_CACHE);
+
+	for (it = pool->free[0]; it; it = it->next) {
+		n++;
+	}
+
+	CHECK(n + (int) cache->count[0] == LRE_POOL_CACHE * 3);
+
+	lre_buffer_pool_flush(pool);
+	lre_buffer_pool_close(pool);
+}
+
+
+int main(void) {
+	test_threads();
+	test_many_pools();
+	test_reuse_address();
+	test_bounded_refill();
+	return TEST_RESULT();
+}
@@ -0,0 +1,137 @@
+/*
+ * Pull reader: lre_reader_init(), lre_reader_next(), lre_reader_done().
+ *   cc -std=c99 -I.. -o test_reader test_reader.c -lm && ./test_reader
+ */
+#include "../lre.h"
+#include "test.h"
+
+
+static lre_buffer_t *buf;
+
+
+static void check_str(const lre_field_t *field, const char *expected, lre_enc_t enc) {
+	lre_slice_t slice = field->as.s.slice;
+	uint8_t     tmp[64];
+	size_t      nbytes = lre_slice_str_nbytes(&slice, field->as.s.enc);
+
+	CHECK(field->type == LRE_TYPE_STR);
+	CHECK(field->as.s.enc == enc);
+	CHECK(nbytes == strlen(expected));
+	CHECK(lre_slice_read_str(&slice, tmp, field->as.s.enc) == LRE_OK);
+	CHECK(memcmp(tmp, expected, nbytes) == 0);
+}
+
+
+static void test_regular(void) {
+	lre_reader_t reader;
+	lre_field_t  field;
+	uint8_t      big[9] = {1, 0, 0, 0, 0, 0, 0, 0, 0};
+
+	lre_buffer_reset_fast(buf);
+	lre_pack_int(buf, INT64_MIN, 0);
+	lre_pack_int(buf, 300, 0);
+	lre_pack_float(buf, -10.5, 0);
+	lre_pack_float(buf, -INFINITY, 0);
+	lre_pack_str(buf, (const uint8_t *) "abc", 3, LRE_ENC_UTF8, 0);
+	lre_pack_bigint(buf, big, sizeof(big), 1, 0);
+	lre_pack_float(buf, 1e300, 0);
+
+	lre_reader_init(&reader, buf->data, buf->size);
+
+	CHECK(lre_reader_next(&reader, &field, 0) == LRE_OK);
+	CHECK(field.type == LRE_TYPE_INT && field.as.i == INT64_MIN);
+
+	CHECK(lre_reader_next(&reader, &field, 0) == LRE_OK);
+	CHECK(field.type == LRE_TYPE_INT && field.as.i == 300 && field.tag == LRE_TAG_NUMBER_POSITIVE_2);
+
+	CHECK(lre_reader_next(&reader, &field, 0) == LRE_OK);
+	CHECK(field.type == LRE_TYPE_FLOAT && field.as.f == -10.5);
+
+	CHECK(lre_reader_next(&reader, &field, 0) == LRE_OK);
+	CHECK(field.type == LRE_TYPE_FLOAT && field.as.f == -INFINITY && field.tag == LRE_TAG_NUMBER_NEGATIVE_INF);
+
+	CHECK(lre_reader_next(&reader, &field, 0) == LRE_OK);
+	check_str(&field, "abc", LRE_ENC_UTF8);
+
+	CHECK(lre_reader_next(&reader, &field, 0) == LRE_OK);
+	CHECK(field.type == LRE_TYPE_BIGINT && field.as.num.integral_nbytes == 9 && field.as.num.negative_mask == 0xff);
+
+	CHECK(lre_reader_next(&reader, &field, 0) == LRE_OK);
+	CHECK(field.type == LRE_TYPE_BIGINT && field.tag == LRE_TAG_NUMBER_POSITIVE_BIG);
+
+	CHECK(lre_reader_done(&reader));
+}
+
+
+static void test_dense(void) {
+	lre_reader_t reader;
+	lre_field_t  field;
+
+	lre_buffer_reset_fast(buf);
+	lre_pack_dense_int(buf, -300, 0);
+	lre_pack_dense_float(buf, 1.5, 0);
+	lre_pack_dense_str(buf, (const uint8_t *) "hello", 5, LRE_ENC_RAW, 0);
+	lre_pack_dense_float(buf, INFINITY, 0);
+	lre_pack_dense_float(buf, 1e30, 0);
+
+	lre_reader_init(&reader, buf->data, buf->size);
+
+	/* Field tag is as in key */
+	CHECK(lre_reader_next(&reader, &field, 0) == LRE_OK);
+	CHECK(field.type == LRE_TYPE_INT && field.as.i == -300);
+	CHECK(field.tag == (lre_tag_t) (LRE_TAG_NUMBER_NEGATIVE_2 | LRE_TAG_DENSE_FLAG));
+
+	CHECK(lre_reader_next(&reader, &field, 0) == LRE_OK);
+	CHECK(field.type == LRE_TYPE_FLOAT && field.as.f == 1.5);
+
+	CHECK(lre_reader_next(&reader, &field, 0) == LRE_OK);
+	check_str(&field, "hello", LRE_ENC_DENSE_RAW);
+
+	CHECK(lre_reader_next(&reader, &field, 0) == LRE_OK);
+	CHECK(field.type == LRE_TYPE_FLOAT && field.as.f == INFINITY);
+
+	/* Tag of transcoded number is regular */
+	CHECK(lre_reader_next(&reader, &field, 0) == LRE_OK);
+	CHECK(field.type == LRE_TYPE_BIGINT && field.tag == (lre_tag_t) (LRE_TAG_NUMBER_POSITIVE_BIG | LRE_TAG_DENSE_FLAG));
+	CHECK(field.as.num.tag == LRE_TAG_NUMBER_POSITIVE_BIG && field.as.num.integral_nbytes == 13);
+
+	CHECK(lre_reader_done(&reader));
+}
+
+
+static void test_errors(void) {
+	lre_reader_t reader;
+	lre_field_t  field;
+	lre_error_t  error;
+
+	/* Not terminated */
+	error = LRE_ERROR_NOTHING;
+	lre_reader_init(&reader, (const uint8_t *) "Mab", 3);
+	CHECK(lre_reader_next(&reader, &field, &error) != LRE_OK && error == LRE_ERROR_LENGTH);
+
+	/* Unknown tag */
+	error = LRE_ERROR_NOTHING;
+	lre_reader_init(&reader, (const uint8_t *) "Zab+", 4);
+	CHECK(lre_reader_next(&reader, &field, &error) != LRE_OK && error == LRE_ERROR_TAG);
+
+	/* 8-byte integer out of 64-bit range */
+	error = LRE_ERROR_NOTHING;
+	lre_reader_init(&reader, (const uint8_t *) "Tiaaaaaaaaaaaaaaa+", 18);
+	CHECK(lre_reader_next(&reader, &field, &error) != LRE_OK && error == LRE_ERROR_RANGE);
+
+	/* The largest 8-byte integer in range */
+	lre_reader_init(&reader, (const uint8_t *) "Thppppppppppppppp+", 18);
+	CHECK(lre_reader_next(&reader, &field, 0) == LRE_OK && field.as.i == INT64_MAX);
+}
+
+
+int main(void) {
+	buf = lre_buffer_create(0, 0);
+
+	test_regular();
+	test_dense();
+	test_errors();
+
+	lre_buffer_close(buf);
+	return TEST_RESULT();
+}
@@ -0,0 +1,237 @@
+/*
+ * Columnar decode: lre_unpack_columns(), also round trip of lre_pack_columns().
+ *   cc -std=c99 -I.. -o test_unpack test_unpack.c -lm && ./test_unpack
+ */
+#include "../lre.h"
+#include "test.h"
+
+
+#define NROWS 4
+
+
+static lre_buffer_t *buf;
+static lre_slice_t   keys[NROWS];
+
+
+static void make_keys(void) {
+	size_t offsets[NROWS + 1];
+	size_t r;
+
+	buf = lre_buffer_create(0, 0);
+
+	for (r = 0; r < NROWS; r++) {
+		offsets[r] = buf->size;
+
+		if (r == 2) {
+			/* Row 2 does not match schema */
+			lre_pack_str(buf, (const uint8_t *) "bad", 3, LRE_ENC_RAW, 0);
+			continue;
+		}
+
+		lre_pack_int(buf, (int64_t) r * 10, 0);
+		lre_pack_int(buf, -(int64_t) r, 0);
+		lre_pack_dense_str(buf, (const uint8_t *) "row", 3 - (r & 1), LRE_ENC_RAW, 0);
+	}
+
+	offsets[NROWS] = buf->size;
+
+	for (r = 0; r < NROWS; r++) {
+		keys[r].src = buf->data + offsets[r];
+		keys[r].end = buf->data + offsets[r + 1];
+	}
+}
+
+
+static void test_columns(void) {
+	int64_t             ints[NROWS];
+	double              floats[NROWS];
+	size_t              offsets[NROWS + 1];
+	uint64_t            mismatch;
+	lre_buffer_t       *arena = lre_buffer_create(0, 0);
+	lre_unpack_column_t columns[3];
+
+	memset(columns, 0, sizeof(columns));
+	columns[0].type    = LRE_TYPE_INT;
+	columns[0].data    = ints;
+	columns[1].type    = LRE_TYPE_FLOAT;
+	columns[1].data    = floats;
+	columns[2].type    = LRE_TYPE_STR;
+	columns[2].offsets = offsets;
+	columns[2].arena   = arena;
+
+	CHECK(lre_unpack_columns(keys, NROWS, columns, 3, &mismatch, 0) == LRE_OK);
+	CHECK(mismatch == 4);
+
+	CHECK(ints[0] == 0 && ints[1] == 10 && ints[2] == 0 && ints[3] == 30);
+	CHECK(floats[1] == -1.0 && floats[2] == 0 && floats[3] == -3.0);
+	CHECK(offsets[0] == 0 && offsets[1] == 3 && offsets[2] == 5 && offsets[3] == 5 && offsets[4] == 7);
+	CHECK(arena->size == 7 && memcmp(arena->data, "rowroro", 7) == 0);
+
+	lre_buffer_close(arena);
+}
+
+
+static void test_bad_schema(void) {
+	static const lre_type_t bad[3] = {LRE_TYPE_BIGINT, LRE_TYPE_BIGFLOAT, (lre_type_t) 77};
+	int64_t             ints[NROWS];
+	uint64_t            mismatch;
+	lre_unpack_column_t columns[2];
+	lre_error_t         error;
+	size_t              i;
+
+	for (i = 0; i < 3; i++) {
+		memset(columns, 0, sizeof(columns));
+		columns[0].type = LRE_TYPE_INT;
+		columns[0].data = ints;
+		columns[1].type = bad[i];
+		columns[1].data = ints;
+
+		/* Rejected before any row is read */
+		ints[0]  = 12345;
+		mismatch = 12345;
+		error    = LRE_ERROR_NOTHING;
+		CHECK(lre_unpack_columns(keys, NROWS, columns, 2, &mismatch, &error) != LRE_OK);
+		CHECK(error == LRE_ERROR_TYPE);
+		CHECK(ints[0] == 12345 && mismatch == 12345);
+	}
+
+	/* Missing arrays */
+	memset(columns, 0, sizeof(columns));
+	columns[0].type = LRE_TYPE_STR;
+	error = LRE_ERROR_NOTHING;
+	CHECK(lre_unpack_columns(keys, NROWS, columns, 1, &mismatch, &error) != LRE_OK && error == LRE_ERROR_NULLPTR);
+}
+
+
+static void test_big_floats(void) {
+	static const double values[4] = {1e20, -1e300, 2.5, 0x1p+63};
+	lre_buffer_t       *kbuf = lre_buffer_create(0, 0);
+	lre_column_t        column;
+	lre_unpack_column_t ucolumn;
+	lre_slice_t         slices[4];
+	size_t              offsets[5];
+	double              floats[4];
+	uint64_t            mismatch;
+	size_t              r;
+
+	/* Output of lre_pack_columns() with |x| >= 2^63 is decoded */
+	memset(&column, 0, sizeof(column));
+	column.type = LRE_TYPE_FLOAT;
+	column.data = values;
+	CHECK(lre_pack_columns(kbuf, &column, 1, 4, offsets, 0) == LRE_OK);
+
+	for (r = 0; r < 4; r++) {
+		slices[r].src = kbuf->data + offsets[r];
+		slices[r].end = kbuf->data + offsets[r + 1];
+	}
+
+	memset(&ucolumn, 0, sizeof(ucolumn));
+	ucolumn.type = LRE_TYPE_FLOAT;
+	ucolumn.data = floats;
+	CHECK(lre_unpack_columns(slices, 4, &ucolumn, 1, &mismatch, 0) == LRE_OK);
+	CHECK(mismatch == 0);
+	CHECK(memcmp(floats, values, sizeof(values)) == 0);
+
+	lre_buffer_close(kbuf);
+}
+
+
+static void test_pack_columns(void) {
+	static const int64_t  ints[NROWS]   = {INT64_MIN, -1, 0, 300};
+	static const double   floats[NROWS] = {-0.5, 1e20, 3.0, INFINITY};
+	static const uint8_t *strs[NROWS]   = {(const uint8_t *) "a", (const uint8_t *) "", (const uint8_t *) "xyz", (const uint8_t *) "bc"};
+	static const size_t   lens[NROWS]   = {1, 0, 3, 2};
+	lre_buffer_t       *kbuf  = lre_buffer_create(0, 0);
+	lre_buffer_t       *row   = lre_buffer_create(0, 0);
+	lre_buffer_t       *arena = lre_buffer_create(0, 0);
+	lre_column_t        columns[3];
+	lre_unpack_column_t ucolumns[3];
+	lre_val_t           vals[NROWS];
+	lre_slice_t         slices[NROWS];
+	size_t              offsets[NROWS + 1];
+	size_t              soffsets[NROWS + 1];
+	int64_t             uints[NROWS];
+	double              ufloats[NROWS];
+	uint64_t            mismatch;
+	lre_error_t         error;
+	size_t              r, size;
+
+	memset(columns, 0, sizeof(columns));
+	columns[0].type = LRE_TYPE_INT;
+	columns[0].data = ints;
+	columns[1].type = LRE_TYPE_FLOAT;
+	columns[1].data = floats;
+	columns[2].type = LRE_TYPE_STR;
+	columns[2].data = strs;
+	columns[2].lens = lens;
+	columns[2].enc  = LRE_ENC_UTF8;
+
+	/* Keys are appended after existing content */
+	lre_pack_str(kbuf, (const uint8_t *) "prefix", 6, LRE_ENC_RAW, 0);
+	size = kbuf->size;
+	CHECK(lre_pack_columns(kbuf, columns, 3, NROWS, offsets, 0) == LRE_OK);
+	CHECK(offsets[0] == size && offsets[NROWS] == kbuf->size && kbuf->data[kbuf->size] == 0);
+
+	lre_columns_vals(kbuf, offsets, NROWS, vals);
+
+	/* Each key is the same as its row packed field by field */
+	for (r = 0; r < NROWS; r++) {
+		lre_buffer_reset_fast(row);
+		lre_pack_int(row, ints[r], 0);
+		lre_pack_float(row, floats[r], 0);
+		lre_pack_str(row, strs[r], lens[r], LRE_ENC_UTF8, 0);
+
+		CHECK(vals[r].data == kbuf->data + offsets[r] && vals[r].size == offsets[r + 1] - offsets[r]);
+		CHECK(vals[r].size == row->size && memcmp(vals[r].data, row->data, row->size) == 0);
+
+		slices[r].src = kbuf->data + offsets[r];
+		slices[r].end = kbuf->data + offsets[r + 1];
+	}
+
+	/* And back */
+	memset(ucolumns, 0, sizeof(ucolumns));
+	ucolumns[0].type    = LRE_TYPE_INT;
+	ucolumns[0].data    = uints;
+	ucolumns[1].type    = LRE_TYPE_FLOAT;
+	ucolumns[1].data    = ufloats;
+	ucolumns[2].type    = LRE_TYPE_STR;
+	ucolumns[2].offsets = soffsets;
+	ucolumns[2].arena   = arena;
+
+	CHECK(lre_unpack_columns(slices, NROWS, ucolumns, 3, &mismatch, 0) == LRE_OK && mismatch == 0);
+	CHECK(memcmp(uints, ints, sizeof(ints)) == 0);
+	CHECK(memcmp(ufloats, floats, sizeof(floats)) == 0);
+
+	for (r = 0; r < NROWS; r++) {
+		CHECK(soffsets[r + 1] - soffsets[r] == lens[r]);
+		CHECK(memcmp(arena->data + soffsets[r], strs[r], lens[r]) == 0);
+	}
+
+	/* Invalid value in the last row: nothing is written */
+	size = kbuf->size;
+	ufloats[NROWS - 1] = NAN;
+	columns[1].data = ufloats;
+	error = LRE_ERROR_NOTHING;
+	CHECK(lre_pack_columns(kbuf, columns, 3, NROWS, offsets, &error) != LRE_OK && error == LRE_ERROR_NAN);
+	CHECK(kbuf->size == size);
+
+	columns[1].type = LRE_TYPE_BIGINT;
+	error = LRE_ERROR_NOTHING;
+	CHECK(lre_pack_columns(kbuf, columns, 3, NROWS, offsets, &error) != LRE_OK && error == LRE_ERROR_TYPE);
+	CHECK(kbuf->size == size);
+
+	lre_buffer_close(kbuf);
+	lre_buffer_close(row);
+	lre_buffer_close(arena);
+}
+
+
+int main(void) {
+	make_keys();
+	test_columns();
+	test_bad_schema();
+	test_big_floats();
+	test_pack_columns();
+	lre_buffer_close(buf);
+	return TEST_RESULT();
+}
@@ -0,0 +1,85 @@
+/*
+ * Validation of untrusted keys: lre_validate().
+ *   cc -std=c99 -I.. -o test_validate test_validate.c -lm && ./test_validate
+ */
+#include "../lre.h"
+#include "test.h"
+
+
+static void check_invalid(const char *key, lre_error_t expected, size_t expected_offset) {
+	lre_error_t error  = LRE_ERROR_NOTHING;
+	size_t      offset = 12345;
+
+	CHECK(lre_validate((const uint8_t *) key, strlen(key), &error, &offset) != LRE_OK);
+
+	if (error != expected || offset != expected_offset) {
+		test_failures++;
+		fprintf(stderr, "%s: %s at %i, expected %s at %i\n", key,
+		        lre_strerror(error), (int) offset, lre_strerror(expected), (int) expected_offset);
+	}
+}
+
+
+static void test_valid(void) {
+	lre_buffer_t *buf = lre_buffer_create(0, 0);
+	uint8_t       big[9] = {1, 0, 0, 0, 0, 0, 0, 0, 0};
+
+	/* Everything packers produce is valid */
+	lre_pack_int(buf, INT64_MIN, 0);
+	lre_pack_int(buf, INT64_MAX, 0);
+	lre_pack_int(buf, 0, 0);
+	lre_pack_float(buf, -0.125, 0);
+	lre_pack_float(buf, INFINITY, 0);
+	lre_pack_float(buf, -INFINITY, 0);
+	lre_pack_bigint(buf, big, sizeof(big), 0, 0);
+	lre_pack_bigint(buf, big, sizeof(big), 1, 0);
+	lre_pack_str(buf, (const uint8_t *) "raw", 3, LRE_ENC_RAW, 0);
+	lre_pack_str(buf, (const uint8_t *) "", 0, LRE_ENC_UTF8, 0);
+	lre_pack_dense_int(buf, -300, 0);
+	lre_pack_dense_float(buf, 1e30, 0);
+	lre_pack_dense_str(buf, (const uint8_t *) "dense", 5, LRE_ENC_RAW, 0);
+
+	CHECK(lre_validate(buf->data, buf->size, 0, 0) == LRE_OK);
+	CHECK(lre_validate(buf->data, 0, 0, 0) == LRE_OK);
+
+	/* The largest 8-byte integer in range */
+	CHECK(lre_validate((const uint8_t *) "Thppppppppppppppp+", 18, 0, 0) == LRE_OK);
+
+	lre_buffer_close(buf);
+}
+
+
+static void test_invalid(void) {
+	/* Separator does not match sign */
+	check_invalid("Mab~", LRE_ERROR_SIGN, 0);
+	check_invalid("Lpo+", LRE_ERROR_SIGN, 0);
+	check_invalid("Mab+XgbH~", LRE_ERROR_SIGN, 4);
+
+	/* Odd number of nibbles */
+	check_invalid("XgbgH+", LRE_ERROR_LENGTH, 0);
+	check_invalid("Mabc+", LRE_ERROR_LENGTH, 0);
+
+	/* Nibble out of alphabet */
+	check_invalid("XgbgzH+", LRE_ERROR_CHAR, 0);
+	check_invalid("Mab+Maq+", LRE_ERROR_CHAR, 4);
+
+	/* BIG without integral part */
+	check_invalid("Uaaaa+", LRE_ERROR_LENGTH, 0);
+	check_invalid("Mab+Daaaa~", LRE_ERROR_LENGTH, 4);
+
+	/* 8-byte integer beyond 64-bit range must be BIG */
+	check_invalid("Tiaaaaaaaaaaaaaaa+", LRE_ERROR_RANGE, 0);
+
+	/* Tag, encoding, terminator */
+	check_invalid("Zab+", LRE_ERROR_TAG, 0);
+	check_invalid("xgbH+", LRE_ERROR_ENC, 0);
+	check_invalid("Mab+Mab", LRE_ERROR_LENGTH, 4);
+	check_invalid("Mab++", LRE_ERROR_LENGTH, 4);
+}
+
+
+int main(void) {
+	test_valid();
+	test_invalid();
+	return TEST_RESULT();
+}